@@ -4,6 +4,17 @@ from dqnmodel import ReplayBuffer, DuelingDQN
 from parsers import args 
 import csv
 import time
+import threading
+
+class Session:
+    """Previous state and action of one connection, so that episodes running
+    at the same time do not mix their transitions"""
+    def __init__(self):
+        self.reset()
+    def reset(self):
+        self.last_state = None  # None until the first action of the episode
+        self.last_action = 0
+        self.sum_reward = 0
 
 class RLAgent:
     def __init__(self, env_name, m_states_dim, m_actions_dim):
@@ -14,13 +25,11 @@ class RLAgent:
         # Create environment
         self.n_states = m_states_dim
         self.n_actions = m_actions_dim
-        self.last_state = [0,0,0,0]
-        self.last_action = 0
-        self.sum_reward = 0
+        self.session = Session()  # Used when the caller has no session of its own
         self.sum_reward_list = []  # Record the reward for each episode
         self.episode = 1
-        self.isfirst = True
         self.episodeCount  = 0
+        self.lock = threading.Lock()  # Connections share the model and the replay buffer
 
         # Experience replay buffer
         self.replay_buffer = ReplayBuffer(capacity=self.args.buffer_size)
@@ -35,16 +44,16 @@ class RLAgent:
                           device=self.device,
                           updatePeriod=self.args.update_period
                           )
-    def select_action(self, state):
+    def select_action(self, state, session):
         epsilon = 1 / (self.episode/5 + 1)
         action = self.agent.take_action(state, epsilon)
-        self.last_state = state
-        self.last_action = action
+        session.last_state = state
+        session.last_action = action
         return action
-    def agent_update(self, reward, next_state, done):
-        self.replay_buffer.add(self.last_state, self.last_action, reward, next_state, done) #Add experience to replay pool
+    def agent_update(self, reward, next_state, done, session):
+        self.replay_buffer.add(session.last_state, session.last_action, reward, next_state, done) #Add experience to replay pool
         self.episodeCount+=1
-        self.sum_reward += reward
+        session.sum_reward += reward
         # If the experience pool exceeds min_size, start training
         if self.replay_buffer.size() > self.args.min_size:
             # Random sampling of batch_size group from the experience pool
@@ -60,20 +69,21 @@ class RLAgent:
             # Model train
             self.agent.update(transition_dict)
 
-    def get_action_by_one_step(self, state, reward, done):
-        if not self.isfirst:
-            self.agent_update(reward, state, done)
-        action = self.select_action(state)
-        self.isfirst = False
-        return action
-    def done_print(self):
-        self.episodeCount = 0
-        self.sum_reward_list.append(self.sum_reward)
-        self.sum_reward = 0
-        self.episode +=1
-        self.isfirst = True
-        self.agent.end_of_epoch()
-        self.agent.save_models('dueling_dqn.pth','target_dueling_dqn.pth')
+    def get_action_by_one_step(self, state, reward, done, session=None):
+        session = session or self.session
+        with self.lock:
+            if session.last_state is not None:
+                self.agent_update(reward, state, done, session)
+            return self.select_action(state, session)
+    def done_print(self, session=None):
+        session = session or self.session
+        with self.lock:
+            self.episodeCount = 0
+            self.sum_reward_list.append(session.sum_reward)
+            session.reset()
+            self.episode +=1
+            self.agent.end_of_epoch()
+            self.agent.save_models('dueling_dqn.pth','target_dueling_dqn.pth')
     def show_reward_pic(self):
         csv_file = 'reward_data.csv'
         with open(csv_file, 'w', newline='') as file:
@@ -12,6 +12,8 @@ parser.add_argument('--gamma', type=float, default=0.99, help='Discount factor')
 parser.add_argument('--buffer_size', type=int, default=5000, help='Capacity of the experience replay buffer')
 parser.add_argument('--min_size', type=int, default=200, help='Start training when the experience replay buffer size exceeds 200')
 parser.add_argument('--batch_size', type=int, default=64, help='Number of samples per training batch')
+parser.add_argument('--n_states', type=int, default=4, help='State dimension, 4 plus the extra features enabled in the queue disc')
+parser.add_argument('--snapshot_step', type=int, default=0, help='Ask the simulation to fork episodes from a snapshot after this many steps, 0 to never ask')
 parser.add_argument('--update_period', type=int, default=100, help='Interval for model updates')
 
 # Parse the arguments
@@ -3,15 +3,21 @@ import threading
 import time
 import json
 import torch
-from agent import RLAgent
+from agent import RLAgent, Session
+from parsers import args
 
 def handle_client(connection, address):
     try:
         print("Connected to:", address)
+        steps = 0
+        session = Session()  # Forked episodes connect at the same time, keep their transitions apart
 
         while True:
             recv_str = connection.recv(1024)
-            if recv_str== b'\x00':
+            if not recv_str:
+                # Closed without a done state, e.g. by a snapshot template
+                break
+            elif recv_str== b'\x00':
                 break
             elif recv_str==b'CLOSE_CONNECT\x00':
                 print('rl agent train over')
@@ -22,18 +28,21 @@ def handle_client(connection, address):
             # Parse the received JSON data
             data = json.loads(json_data)
             
-            state = [data["a"], data["b"], data["c"], data["d"]]
+            state = [data["a"], data["b"], data["c"], data["d"]] + data.get("extra", [])
             reward =data["reward"]
             # print(f'state is {state[0]} {state[1]} {state[2]} {state[3]}, reward is {reward}')
             done = data["done"]
             if not done:
-                action = rl_agent.get_action_by_one_step(state, reward, done)
+                action = rl_agent.get_action_by_one_step(state, reward, done, session)
                 
                 send_str = str(action)
+                steps += 1
+                if steps == args.snapshot_step:
+                    send_str = 'snapshot\0' + send_str
                 connection.send(bytes(send_str + '\0', "ascii"))  
 
             else:
-                rl_agent.done_print()
+                rl_agent.done_print(session)
                 break
 
     except Exception as e:
@@ -61,5 +70,5 @@ def DRLServer():
 if __name__ == '__main__':
     print(torch.__version__)
     env_name = "DuelingDQN-NS3-v0"  # env name
-    rl_agent = RLAgent(env_name, 4, 3)  # Create RLAgent instance
+    rl_agent = RLAgent(env_name, args.n_states, 3)  # Create RLAgent instance
     DRLServer()
\ No newline at end of file
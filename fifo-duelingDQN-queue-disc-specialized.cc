@@ -0,0 +1,63 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 Universita' degli Studi di Napoli Federico II
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ */
+
+#include "fifo-duelingDQN-queue-disc-specialized.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SpecializedDuelingDQNFifoQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (SpecializedDuelingDQNQueueDisc);
+
+TypeId SpecializedDuelingDQNQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SpecializedDuelingDQNQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+  ;
+  return tid;
+}
+
+SpecializedDuelingDQNQueueDisc::SpecializedDuelingDQNQueueDisc ()
+  : QueueDisc (QueueDiscSizePolicy::SINGLE_INTERNAL_QUEUE)
+{
+}
+
+SpecializedDuelingDQNQueueDisc::~SpecializedDuelingDQNQueueDisc ()
+{
+}
+
+template class SpecializedDuelingDQNFifoQueueDisc<PacketSizing, BaseSchema, StubDecision>;
+template class SpecializedDuelingDQNFifoQueueDisc<PacketSizing, BaseSchema, NativeDecision>;
+template class SpecializedDuelingDQNFifoQueueDisc<PacketSizing, BaseSchema, AgentDecision>;
+template class SpecializedDuelingDQNFifoQueueDisc<PacketSizing, BaseSchema, AgentDecision, DecisionInstrumentation>;
+template class SpecializedDuelingDQNFifoQueueDisc<PacketSizing, EcnSchema, AgentDecision>;
+template class SpecializedDuelingDQNFifoQueueDisc<PacketSizing, FlowSchema, AgentDecision>;
+template class SpecializedDuelingDQNFifoQueueDisc<ByteSizing, BaseSchema, AgentDecision>;
+
+NS_OBJECT_ENSURE_REGISTERED (PacketStubDuelingDQNFifoQueueDisc);
+NS_OBJECT_ENSURE_REGISTERED (PacketNativeDuelingDQNFifoQueueDisc);
+NS_OBJECT_ENSURE_REGISTERED (PacketAgentDuelingDQNFifoQueueDisc);
+NS_OBJECT_ENSURE_REGISTERED (PacketAgentTimedDuelingDQNFifoQueueDisc);
+NS_OBJECT_ENSURE_REGISTERED (PacketEcnAgentDuelingDQNFifoQueueDisc);
+NS_OBJECT_ENSURE_REGISTERED (PacketFlowAgentDuelingDQNFifoQueueDisc);
+NS_OBJECT_ENSURE_REGISTERED (ByteAgentDuelingDQNFifoQueueDisc);
+
+} // namespace ns3
@@ -0,0 +1,515 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 Universita' degli Studi di Napoli Federico II
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ */
+
+#ifndef DUELINGDQN_FIFO_QUEUE_DISC_SPECIALIZED_H
+#define DUELINGDQN_FIFO_QUEUE_DISC_SPECIALIZED_H
+
+#include "ns3/queue-disc.h"
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+#include "ns3/traced-value.h"
+#include "ns3/traced-callback.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/net-device.h"
+#include "ns3/net-device-queue-interface.h"
+#include "fifo-duelingDQN-queue-disc.h"
+
+#include <iostream>
+#include <string>
+#include "ns3/ns3socket-module.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * Common base of the SpecializedDuelingDQNFifoQueueDisc variants, so that
+ * they can be found with DynamicCast whatever their parameters.
+ */
+class SpecializedDuelingDQNQueueDisc : public QueueDisc {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  virtual ~SpecializedDuelingDQNQueueDisc ();
+
+  /**
+   * \return the number of decisions taken so far
+   */
+  virtual uint32_t GetDecisionCount (void) const = 0;
+
+protected:
+  SpecializedDuelingDQNQueueDisc ();
+};
+
+/**
+ * \ingroup traffic-control
+ *
+ * DuelingDQNFifoQueueDisc with its configuration fixed at compile time.
+ *
+ * The sizing unit (PacketSizing, ByteSizing), the observation schema
+ * (BaseSchema, FlowSchema, EcnSchema, FlowEcnSchema), the decision policy
+ * (StubDecision, NativeDecision, AgentDecision) and the instrumentation
+ * level (NoInstrumentation, DecisionInstrumentation) are template
+ * parameters of a BufferControlCore. Enqueue, dequeue and the decisions
+ * then run without StatusTrigger output, unit or feature checks and
+ * virtual rate estimator calls, and the internal queue is cached.
+ *
+ * The decisions are the ones of DuelingDQNFifoQueueDisc with the same
+ * configuration. Snapshots, the buffer size trace and the Chrome trace are
+ * not available.
+ *
+ * Only the combinations registered below have a TypeId, e.g.
+ * "ns3::DuelingDQNFifoQueueDisc<Packets,Base,Agent,Untimed>".
+ */
+template <class Sizing, class Schema, class Policy, class Instrumentation = NoInstrumentation>
+class SpecializedDuelingDQNFifoQueueDisc : public SpecializedDuelingDQNQueueDisc {
+public:
+  /// The control logic
+  typedef BufferControlCore<Sizing, Schema> Core;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief SpecializedDuelingDQNFifoQueueDisc constructor
+   *
+   * Creates a queue of Sizing::DEFAULT_SIZE by default
+   */
+  SpecializedDuelingDQNFifoQueueDisc ();
+
+  virtual ~SpecializedDuelingDQNFifoQueueDisc ();
+
+  virtual uint32_t GetDecisionCount (void) const;
+
+protected:
+  /**
+   * \brief Dispose of the object
+   */
+  virtual void DoDispose (void);
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual Ptr<const QueueDiscItem> DoPeek (void);
+  virtual bool CheckConfig (void);
+  virtual void InitializeParams (void);
+
+  void SelectAction (void);
+  void CalculateRewards (void);
+  void SeedRateEstimator (void);  //Seed the dequeue rate from the attached device
+
+  void StartPolicy (AgentDecision& policy); //Connect to the agent
+  void FinishPolicy (AgentDecision& policy);  //Send the done state and report the fallbacks
+  template <class P>
+  void StartPolicy (P&) {}  //Embedded policies need no setup
+  template <class P>
+  void FinishPolicy (P&) {}
+
+  /// The unit of the buffer sizes set on the queue disc
+  static QueueSizeUnit GetUnit (void)
+  {
+    return Sizing::BYTES ? QueueSizeUnit::BYTES : QueueSizeUnit::PACKETS;
+  }
+
+  NS_LOG_TEMPLATE_DECLARE;  //!< The log component of the instantiations
+  Core m_core;  // Slot counters, observation, reward, actions, rate estimator and flow table
+  Policy m_policy;
+  Instrumentation m_instrumentation;
+  Ptr<InternalQueue> m_queue; // The internal queue, cached by CheckConfig
+  EventId m_eventId;
+
+  Time m_updatePeriod;  // Slot time
+  Time m_desiredQueueDelay;
+  Time m_rateHalfLife;  // Half-life of the EWMA byte counter
+  bool m_seedFromDevice;  // Seed the rate estimate with the device DataRate
+  double m_markRatio; // Marking threshold as a fraction of the buffer size, with Schema::ECN
+  double m_signalPenalty; // Reward penalty per dropped or marked fraction of arrivals, with Schema::ECN
+  uint32_t m_flowTableSize; // Entries of the per-flow table, with Schema::FLOWS
+  Time m_flowAgeTimeout;  // Idle time after which a flow entry may be reused
+  uint32_t m_episode;
+
+  std::string m_agentAddress; // Address of the agent server
+  uint16_t m_agentPort; // Port of the agent server
+  Time m_decisionDeadline;  // Wall-clock budget of an agent decision, 0 to wait forever
+  Time m_agentTimeout;  // Reconnect when a reply is this late
+  DuelingDQNFifoQueueDisc::DecisionPolicy m_fallbackPolicy;  // Policy applied when the agent gives no action
+  uint32_t m_fallbackAction;  // Action applied by the STUB fallback policy
+
+  TracedValue<double> trace_rewardSum;
+  TracedCallback<Time, Time, Time, Time, Time, Time> m_decisionStagesTrace;
+};
+
+template <class Sizing, class Schema, class Policy, class Instrumentation>
+TypeId
+SpecializedDuelingDQNFifoQueueDisc<Sizing, Schema, Policy, Instrumentation>::GetTypeId (void)
+{
+  static TypeId tid = TypeId (("ns3::DuelingDQNFifoQueueDisc<" + std::string (Sizing::GetName ()) + ","
+                               + Schema::GetName () + "," + Policy::GetName () + ","
+                               + Instrumentation::GetName () + ">").c_str ())
+    .SetParent<SpecializedDuelingDQNQueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .template AddConstructor<SpecializedDuelingDQNFifoQueueDisc> ()
+    .AddAttribute ("MaxSize",
+                   "The max queue size, in the unit of the variant",
+                   QueueSizeValue (QueueSize (GetUnit (), Sizing::DEFAULT_SIZE)),
+                   MakeQueueSizeAccessor (&QueueDisc::SetMaxSize,
+                                          &QueueDisc::GetMaxSize),
+                   MakeQueueSizeChecker ())
+    .AddAttribute ("UpdatePeriod",
+                   "Slot time",
+                   TimeValue (Seconds (0.01)),
+                   MakeTimeAccessor (&SpecializedDuelingDQNFifoQueueDisc::m_updatePeriod),
+                   MakeTimeChecker ())
+    .AddAttribute ("DesiredQueueDelay",
+                   "Desired queueing delay",
+                   TimeValue (Seconds (2)),
+                   MakeTimeAccessor (&SpecializedDuelingDQNFifoQueueDisc::m_desiredQueueDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("RateHalfLife",
+                   "Half-life of the Ewma rate estimator",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&SpecializedDuelingDQNFifoQueueDisc::m_rateHalfLife),
+                   MakeTimeChecker ())
+    .AddAttribute ("SeedFromDevice",
+                   "Seed the rate estimate with the DataRate of the attached device, if it has one",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&SpecializedDuelingDQNFifoQueueDisc::m_seedFromDevice),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Episode",
+                   "N th episode",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&SpecializedDuelingDQNFifoQueueDisc::m_episode),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MarkRatio",
+                   "ECN marking threshold as a fraction of the buffer size, for the Ecn schemas",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&SpecializedDuelingDQNFifoQueueDisc::m_markRatio),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("SignalPenalty",
+                   "Reward penalty for the fraction of arrivals dropped or marked in a slot, for the Ecn schemas",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&SpecializedDuelingDQNFifoQueueDisc::m_signalPenalty),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("FlowTableSize",
+                   "Number of entries of the per-flow accounting table, for the Flows schemas",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&SpecializedDuelingDQNFifoQueueDisc::m_flowTableSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("FlowAgeTimeout",
+                   "Idle time after which a flow table entry may be reused by another flow",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&SpecializedDuelingDQNFifoQueueDisc::m_flowAgeTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("AgentAddress",
+                   "IPv4 address of the agent server, for the Agent policy",
+                   StringValue ("127.0.0.1"),
+                   MakeStringAccessor (&SpecializedDuelingDQNFifoQueueDisc::m_agentAddress),
+                   MakeStringChecker ())
+    .AddAttribute ("AgentPort",
+                   "Port of the agent server, for the Agent policy",
+                   UintegerValue (8888),
+                   MakeUintegerAccessor (&SpecializedDuelingDQNFifoQueueDisc::m_agentPort),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("DecisionDeadline",
+                   "Wall-clock budget from sending the state to receiving the action, 0 to wait forever",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&SpecializedDuelingDQNFifoQueueDisc::m_decisionDeadline),
+                   MakeTimeChecker ())
+    .AddAttribute ("AgentTimeout",
+                   "Wall-clock time after which a late agent is considered hung and the connection is reopened",
+                   TimeValue (Seconds (5)),
+                   MakeTimeAccessor (&SpecializedDuelingDQNFifoQueueDisc::m_agentTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("FallbackPolicy",
+                   "Policy applied when the agent gives no valid action in time. Stub applies FallbackAction",
+                   EnumValue (DuelingDQNFifoQueueDisc::STUB),
+                   MakeEnumAccessor (&SpecializedDuelingDQNFifoQueueDisc::m_fallbackPolicy),
+                   MakeEnumChecker (DuelingDQNFifoQueueDisc::STUB, "Stub",
+                                    DuelingDQNFifoQueueDisc::NATIVE, "Native"))
+    .AddAttribute ("FallbackAction",
+                   "Action of the Stub fallback policy: 0 add, 1 keep, 2 reduce",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&SpecializedDuelingDQNFifoQueueDisc::m_fallbackAction),
+                   MakeUintegerChecker<uint32_t> (0, 2))
+    .AddTraceSource ("SumReward",
+                     "the sum reward of one episode",
+                     MakeTraceSourceAccessor (&SpecializedDuelingDQNFifoQueueDisc::trace_rewardSum),
+                     "ns3::TracedValueCallback::double")
+    .AddTraceSource ("DecisionStages",
+                     "Wall-clock time of each stage of a decision, fired by the Timed variants",
+                     MakeTraceSourceAccessor (&SpecializedDuelingDQNFifoQueueDisc::m_decisionStagesTrace),
+                     "ns3::DuelingDQNFifoQueueDisc::DecisionStagesTracedCallback")
+  ;
+  return tid;
+}
+
+template <class Sizing, class Schema, class Policy, class Instrumentation>
+SpecializedDuelingDQNFifoQueueDisc<Sizing, Schema, Policy, Instrumentation>::SpecializedDuelingDQNFifoQueueDisc ()
+  : NS_LOG_TEMPLATE_DEFINE ("SpecializedDuelingDQNFifoQueueDisc"),
+    m_core (EwmaRateEstimator (0.01))
+{
+  m_eventId = Simulator::Schedule (Seconds (0.0), &SpecializedDuelingDQNFifoQueueDisc::SelectAction, this);
+}
+
+template <class Sizing, class Schema, class Policy, class Instrumentation>
+SpecializedDuelingDQNFifoQueueDisc<Sizing, Schema, Policy, Instrumentation>::~SpecializedDuelingDQNFifoQueueDisc ()
+{
+}
+
+template <class Sizing, class Schema, class Policy, class Instrumentation>
+uint32_t
+SpecializedDuelingDQNFifoQueueDisc<Sizing, Schema, Policy, Instrumentation>::GetDecisionCount (void) const
+{
+  return m_core.GetDecisionCount ();
+}
+
+template <class Sizing, class Schema, class Policy, class Instrumentation>
+void
+SpecializedDuelingDQNFifoQueueDisc<Sizing, Schema, Policy, Instrumentation>::DoDispose (void)
+{
+  std::cout << std::endl << "Sum of rewards: " << m_core.GetRewardsSum () << std::endl;
+  trace_rewardSum = (double)m_core.GetRewardsSum ();
+  std::cout << "Episode " << m_episode << " step count: " << m_core.GetSteps () << std::endl;
+  std::cout << "Number of Add action: " << m_core.GetActionCount (0) << ", Reduce action: " << m_core.GetActionCount (2)
+            << ", Keep action: " << m_core.GetActionCount (1) << std::endl << std::endl;
+  FinishPolicy (m_policy);
+  if (Instrumentation::ENABLED)
+    {
+      std::cout << "Decision loop wall-clock time:" << std::endl;
+      m_instrumentation.GetStats ()->Summary (std::cout);
+    }
+
+  Simulator::Remove (m_eventId);
+  m_queue = 0;
+  QueueDisc::DoDispose ();
+}
+
+template <class Sizing, class Schema, class Policy, class Instrumentation>
+bool
+SpecializedDuelingDQNFifoQueueDisc<Sizing, Schema, Policy, Instrumentation>::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  uint32_t packets = m_queue->GetNPackets ();
+  uint32_t bytes = m_queue->GetNBytes ();
+  uint32_t hash = Schema::FLOWS ? item->Hash () : 0;
+  uint64_t now = Schema::FLOWS ? Simulator::Now ().GetNanoSeconds () : 0;
+
+  if (!m_core.Admit (packets, bytes, item->GetSize (), hash, now))
+    {
+      DropBeforeEnqueue (item, DuelingDQNFifoQueueDisc::LIMIT_EXCEEDED_DROP);
+      return false;
+    }
+  // Non-ECT packets are not marked and only face the hard limit
+  if (m_core.ShouldMark (packets, bytes) && Mark (item, DuelingDQNFifoQueueDisc::MARK_THRESHOLD_EXCEEDED_MARK))
+    {
+      m_core.NotifyMark ();
+    }
+  bool retval = m_queue->Enqueue (item);
+  m_core.NotifyEnqueue (retval, hash, now);
+
+  // If Queue::Enqueue fails, QueueDisc::DropBeforeEnqueue is called by the
+  // internal queue because QueueDisc::AddInternalQueue sets the trace callback
+  return retval;
+}
+
+template <class Sizing, class Schema, class Policy, class Instrumentation>
+Ptr<QueueDiscItem>
+SpecializedDuelingDQNFifoQueueDisc<Sizing, Schema, Policy, Instrumentation>::DoDequeue (void)
+{
+  Ptr<QueueDiscItem> item = m_queue->Dequeue ();
+  if (item)
+    {
+      m_core.NotifyDequeue (item->GetSize (), Schema::FLOWS ? item->Hash () : 0,
+                            Simulator::Now ().GetNanoSeconds (), m_queue->GetNBytes ());
+    }
+  return item;
+}
+
+template <class Sizing, class Schema, class Policy, class Instrumentation>
+Ptr<const QueueDiscItem>
+SpecializedDuelingDQNFifoQueueDisc<Sizing, Schema, Policy, Instrumentation>::DoPeek (void)
+{
+  return m_queue->Peek ();
+}
+
+template <class Sizing, class Schema, class Policy, class Instrumentation>
+bool
+SpecializedDuelingDQNFifoQueueDisc<Sizing, Schema, Policy, Instrumentation>::CheckConfig (void)
+{
+  if (GetNQueueDiscClasses () > 0)
+    {
+      NS_LOG_ERROR ("SpecializedDuelingDQNFifoQueueDisc cannot have classes");
+      return false;
+    }
+
+  if (GetNPacketFilters () > 0)
+    {
+      NS_LOG_ERROR ("SpecializedDuelingDQNFifoQueueDisc needs no packet filter");
+      return false;
+    }
+
+  if (GetMaxSize ().GetUnit () != GetUnit ())
+    {
+      NS_LOG_ERROR ("The MaxSize of " << GetTypeId ().GetName () << " must be in " << Sizing::GetName ());
+      return false;
+    }
+
+  if (GetNInternalQueues () == 0)
+    {
+      // add a DropTail queue
+      AddInternalQueue (CreateObjectWithAttributes<DropTailQueue<QueueDiscItem>>
+                          ("MaxSize", QueueSizeValue (GetMaxSize ())));
+    }
+
+  if (GetNInternalQueues () != 1)
+    {
+      NS_LOG_ERROR ("SpecializedDuelingDQNFifoQueueDisc needs 1 internal queue");
+      return false;
+    }
+
+  m_queue = GetInternalQueue (0);
+  return true;
+}
+
+template <class Sizing, class Schema, class Policy, class Instrumentation>
+void
+SpecializedDuelingDQNFifoQueueDisc<Sizing, Schema, Policy, Instrumentation>::InitializeParams (void)
+{
+  m_core.GetEstimator () = EwmaRateEstimator (m_rateHalfLife.GetSeconds ());
+  if (m_seedFromDevice)
+    {
+      SeedRateEstimator ();
+    }
+  m_core.SetDesiredQueueDelay (m_desiredQueueDelay.GetSeconds ());
+  m_core.SetEcn (m_markRatio, m_signalPenalty);
+  m_core.SetFlowTable (m_flowTableSize, m_flowAgeTimeout.GetNanoSeconds ());
+  m_core.Reset (GetMaxSize ().GetValue ());
+  StartPolicy (m_policy);
+}
+
+template <class Sizing, class Schema, class Policy, class Instrumentation>
+void
+SpecializedDuelingDQNFifoQueueDisc<Sizing, Schema, Policy, Instrumentation>::SeedRateEstimator (void)
+{
+  Ptr<NetDeviceQueueInterface> ndqi = GetNetDeviceQueueInterface ();
+  Ptr<NetDevice> device = ndqi ? ndqi->GetObject<NetDevice> () : 0;
+  DataRateValue rate;
+  if (device && device->GetAttributeFailSafe ("DataRate", rate))
+    {
+      m_core.GetEstimator ().Seed (rate.Get ().GetBitRate () / 8.0);
+    }
+}
+
+template <class Sizing, class Schema, class Policy, class Instrumentation>
+void
+SpecializedDuelingDQNFifoQueueDisc<Sizing, Schema, Policy, Instrumentation>::StartPolicy (AgentDecision& policy)
+{
+  policy.Connect (m_agentAddress, m_agentPort,
+                  m_decisionDeadline.IsStrictlyPositive () ? m_decisionDeadline.GetNanoSeconds () : -1,
+                  m_agentTimeout.GetNanoSeconds (), m_instrumentation.GetStats ());
+  policy.SetFallback (m_fallbackPolicy == DuelingDQNFifoQueueDisc::NATIVE, m_fallbackAction);
+}
+
+template <class Sizing, class Schema, class Policy, class Instrumentation>
+void
+SpecializedDuelingDQNFifoQueueDisc<Sizing, Schema, Policy, Instrumentation>::FinishPolicy (AgentDecision& policy)
+{
+  if (policy.GetClient ())
+    {
+      std::cout << "Fallback decisions: " << policy.GetFallbacks ()
+                << ", Missed deadlines: " << policy.GetClient ()->GetMissedDeadlines ()
+                << ", Reconnects: " << policy.GetClient ()->GetReconnects () << std::endl;
+      policy.Finish ();
+      std::cout << "Train over." << std::endl;
+    }
+}
+
+template <class Sizing, class Schema, class Policy, class Instrumentation>
+void
+SpecializedDuelingDQNFifoQueueDisc<Sizing, Schema, Policy, Instrumentation>::SelectAction (void)
+{
+  uint32_t packets = m_queue ? m_queue->GetNPackets () : 0;
+  if (packets == 0)  // Keep checking until there is a backlog
+    {
+      m_core.IdleSlot ();
+      m_eventId = Simulator::Schedule (m_updatePeriod, &SpecializedDuelingDQNFifoQueueDisc::SelectAction, this);
+      return;
+    }
+
+  uint64_t decisionStart = m_instrumentation.Start ();
+  typename Core::Observation ob;
+  m_core.Observe (packets, m_queue->GetNBytes (), ob);
+  action_t action = m_policy.Decide (m_core, ob);
+  uint32_t maxSize = m_core.ApplyAction (action, packets, m_queue->GetNBytes ());
+  SetMaxSize (QueueSize (GetUnit (), maxSize));
+  if (Instrumentation::ENABLED)
+    {
+      m_instrumentation.End (decisionStart);
+      const DecisionStats* stats = m_instrumentation.GetStats ();
+      m_decisionStagesTrace (NanoSeconds (stats->GetLast (STAGE_SIMULATE)),
+                             NanoSeconds (stats->GetLast (STAGE_SERIALIZE)),
+                             NanoSeconds (stats->GetLast (STAGE_SEND)),
+                             NanoSeconds (stats->GetLast (STAGE_AGENT)),
+                             NanoSeconds (stats->GetLast (STAGE_PARSE)),
+                             NanoSeconds (stats->GetLast (STAGE_DECISION)));
+    }
+  m_eventId = Simulator::Schedule (m_updatePeriod, &SpecializedDuelingDQNFifoQueueDisc::CalculateRewards, this); //Calculate reward after slot time
+}
+
+template <class Sizing, class Schema, class Policy, class Instrumentation>
+void
+SpecializedDuelingDQNFifoQueueDisc<Sizing, Schema, Policy, Instrumentation>::CalculateRewards (void)
+{
+  m_core.CalculateReward (m_queue->GetNPackets (), m_queue->GetNBytes ());
+  m_eventId = Simulator::Schedule (NanoSeconds (0), &SpecializedDuelingDQNFifoQueueDisc::SelectAction, this);
+}
+
+/// The precompiled variants, one TypeId each
+typedef SpecializedDuelingDQNFifoQueueDisc<PacketSizing, BaseSchema, StubDecision> PacketStubDuelingDQNFifoQueueDisc;
+typedef SpecializedDuelingDQNFifoQueueDisc<PacketSizing, BaseSchema, NativeDecision> PacketNativeDuelingDQNFifoQueueDisc;
+typedef SpecializedDuelingDQNFifoQueueDisc<PacketSizing, BaseSchema, AgentDecision> PacketAgentDuelingDQNFifoQueueDisc;
+typedef SpecializedDuelingDQNFifoQueueDisc<PacketSizing, BaseSchema, AgentDecision, DecisionInstrumentation> PacketAgentTimedDuelingDQNFifoQueueDisc;
+typedef SpecializedDuelingDQNFifoQueueDisc<PacketSizing, EcnSchema, AgentDecision> PacketEcnAgentDuelingDQNFifoQueueDisc;
+typedef SpecializedDuelingDQNFifoQueueDisc<PacketSizing, FlowSchema, AgentDecision> PacketFlowAgentDuelingDQNFifoQueueDisc;
+typedef SpecializedDuelingDQNFifoQueueDisc<ByteSizing, BaseSchema, AgentDecision> ByteAgentDuelingDQNFifoQueueDisc;
+
+extern template class SpecializedDuelingDQNFifoQueueDisc<PacketSizing, BaseSchema, StubDecision>;
+extern template class SpecializedDuelingDQNFifoQueueDisc<PacketSizing, BaseSchema, NativeDecision>;
+extern template class SpecializedDuelingDQNFifoQueueDisc<PacketSizing, BaseSchema, AgentDecision>;
+extern template class SpecializedDuelingDQNFifoQueueDisc<PacketSizing, BaseSchema, AgentDecision, DecisionInstrumentation>;
+extern template class SpecializedDuelingDQNFifoQueueDisc<PacketSizing, EcnSchema, AgentDecision>;
+extern template class SpecializedDuelingDQNFifoQueueDisc<PacketSizing, FlowSchema, AgentDecision>;
+extern template class SpecializedDuelingDQNFifoQueueDisc<ByteSizing, BaseSchema, AgentDecision>;
+
+} // namespace ns3
+
+#endif
@@ -0,0 +1,174 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/fifo-duelingDQN-queue-disc.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/data-rate.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/net-device-queue-interface.h"
+
+using namespace ns3;
+
+/**
+ * A queue disc item whose Mark succeeds if it is ECN capable
+ */
+class DuelingDQNQueueDiscTestItem : public QueueDiscItem
+{
+public:
+  DuelingDQNQueueDiscTestItem (Ptr<Packet> p, const Address & addr, bool ecnCapable);
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+
+private:
+  bool m_ecnCapable;
+};
+
+DuelingDQNQueueDiscTestItem::DuelingDQNQueueDiscTestItem (Ptr<Packet> p, const Address & addr, bool ecnCapable)
+  : QueueDiscItem (p, addr, 0),
+    m_ecnCapable (ecnCapable)
+{
+}
+
+void
+DuelingDQNQueueDiscTestItem::AddHeader (void)
+{
+}
+
+bool
+DuelingDQNQueueDiscTestItem::Mark (void)
+{
+  return m_ecnCapable;
+}
+
+// Check that DoEnqueue marks ECT packets from the marking threshold on,
+// with its reason, and drops at the buffer size
+class DuelingDQNQueueDiscEcnTestCase : public TestCase
+{
+public:
+  DuelingDQNQueueDiscEcnTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param useEcn the UseEcn attribute
+   * \return a 10 packet queue disc with the Stub policy, marking from 5 packets on
+   */
+  Ptr<DuelingDQNFifoQueueDisc> CreateQueueDisc (bool useEcn);
+  void Enqueue (Ptr<DuelingDQNFifoQueueDisc> queue, uint32_t n, bool ecnCapable);
+};
+
+DuelingDQNQueueDiscEcnTestCase::DuelingDQNQueueDiscEcnTestCase ()
+  : TestCase ("Check the ECN marking of DuelingDQNFifoQueueDisc")
+{
+}
+
+Ptr<DuelingDQNFifoQueueDisc>
+DuelingDQNQueueDiscEcnTestCase::CreateQueueDisc (bool useEcn)
+{
+  Ptr<DuelingDQNFifoQueueDisc> queue = CreateObject<DuelingDQNFifoQueueDisc> ();
+  queue->SetAttribute ("MaxSize", StringValue ("10p"));
+  queue->SetAttribute ("Policy", StringValue ("Stub"));
+  queue->SetAttribute ("BufferTraceFile", StringValue (""));
+  queue->SetAttribute ("UseEcn", BooleanValue (useEcn));
+  queue->SetAttribute ("MarkRatio", DoubleValue (0.5));
+  queue->Initialize ();
+  return queue;
+}
+
+void
+DuelingDQNQueueDiscEcnTestCase::Enqueue (Ptr<DuelingDQNFifoQueueDisc> queue, uint32_t n, bool ecnCapable)
+{
+  Address dest;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      queue->Enqueue (Create<DuelingDQNQueueDiscTestItem> (Create<Packet> (1000), dest, ecnCapable));
+    }
+}
+
+void
+DuelingDQNQueueDiscEcnTestCase::DoRun (void)
+{
+  // Non-ECT packets are never marked, ECT ones from 5 queued on, and
+  // neither is enqueued above 10
+  Ptr<DuelingDQNFifoQueueDisc> queue = CreateQueueDisc (true);
+  Enqueue (queue, 7, false);
+  Enqueue (queue, 5, true);
+  QueueDisc::Stats stats = queue->GetStats ();
+  NS_TEST_ASSERT_MSG_EQ (queue->GetCurrentSize ().GetValue (), 10, "Marked packets not enqueued");
+  NS_TEST_ASSERT_MSG_EQ (stats.GetNMarkedPackets (DuelingDQNFifoQueueDisc::MARK_THRESHOLD_EXCEEDED_MARK), 3,
+                         "Wrong number of ECT packets marked above the threshold");
+  NS_TEST_ASSERT_MSG_EQ (stats.nTotalMarkedPackets, 3, "Packets marked for another reason");
+  NS_TEST_ASSERT_MSG_EQ (stats.GetNDroppedPackets (DuelingDQNFifoQueueDisc::LIMIT_EXCEEDED_DROP), 2,
+                         "ECT packets above the buffer size not dropped");
+
+  // Without ECN the same ECT packets are only dropped
+  Ptr<DuelingDQNFifoQueueDisc> dropping = CreateQueueDisc (false);
+  Enqueue (dropping, 12, true);
+  stats = dropping->GetStats ();
+  NS_TEST_ASSERT_MSG_EQ (stats.nTotalMarkedPackets, 0, "Packets marked with ECN disabled");
+  NS_TEST_ASSERT_MSG_EQ (stats.GetNDroppedPackets (DuelingDQNFifoQueueDisc::LIMIT_EXCEEDED_DROP), 2,
+                         "Packets above the buffer size not dropped");
+
+  Simulator::Destroy ();
+}
+
+// Check that SeedFromDevice seeds the dequeue rate with the DataRate of the
+// device the queue disc is attached to
+class DuelingDQNQueueDiscSeedTestCase : public TestCase
+{
+public:
+  DuelingDQNQueueDiscSeedTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param seed the SeedFromDevice attribute
+   * \return the dequeue rate of a queue disc on an 8 Mbps device, before any departure
+   */
+  double GetInitialRate (bool seed);
+};
+
+DuelingDQNQueueDiscSeedTestCase::DuelingDQNQueueDiscSeedTestCase ()
+  : TestCase ("Check the dequeue rate seeding of DuelingDQNFifoQueueDisc")
+{
+}
+
+double
+DuelingDQNQueueDiscSeedTestCase::GetInitialRate (bool seed)
+{
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAttribute ("DataRate", DataRateValue (DataRate ("8Mbps")));
+  Ptr<NetDeviceQueueInterface> ndqi = CreateObject<NetDeviceQueueInterface> ();
+  device->AggregateObject (ndqi);
+
+  Ptr<DuelingDQNFifoQueueDisc> queue = CreateObject<DuelingDQNFifoQueueDisc> ();
+  queue->SetAttribute ("Policy", StringValue ("Stub"));
+  queue->SetAttribute ("BufferTraceFile", StringValue (""));
+  queue->SetAttribute ("SeedFromDevice", BooleanValue (seed));
+  queue->SetNetDeviceQueueInterface (ndqi);
+  queue->Initialize ();
+  return queue->GetDequeueRate ();
+}
+
+void
+DuelingDQNQueueDiscSeedTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ_TOL (GetInitialRate (true), 1e6, 1, "Dequeue rate not seeded with the device DataRate");
+  NS_TEST_ASSERT_MSG_EQ (GetInitialRate (false), 0, "Dequeue rate seeded with SeedFromDevice disabled");
+  Simulator::Destroy ();
+}
+
+static class DuelingDQNQueueDiscTestSuite : public TestSuite
+{
+public:
+  DuelingDQNQueueDiscTestSuite ()
+    : TestSuite ("duelingdqn-queue-disc", UNIT)
+  {
+    AddTestCase (new DuelingDQNQueueDiscEcnTestCase (), TestCase::QUICK);
+    AddTestCase (new DuelingDQNQueueDiscSeedTestCase (), TestCase::QUICK);
+  }
+} g_duelingDQNQueueDiscTestSuite;
@@ -22,11 +22,19 @@
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
+#include "ns3/string.h"
 #include "ns3/simulator.h"
 #include "ns3/abort.h"
 #include "fifo-duelingDQN-queue-disc.h"
 #include "ns3/object-factory.h"
 #include "ns3/drop-tail-queue.h"
+#include "ns3/net-device.h"
+#include "ns3/net-device-queue-interface.h"
+
+#include <numeric>
+#include <cerrno>
+#include <cstring>
+#include <sys/wait.h>
 
 namespace ns3 {
 
@@ -34,6 +42,25 @@ NS_LOG_COMPONENT_DEFINE ("DuelingDQNFifoQueueDisc");
 
 NS_OBJECT_ENSURE_REGISTERED (DuelingDQNFifoQueueDisc);
 
+static std::vector<DuelingDQNFifoQueueDisc*> g_instances; //!< Live instances, reopened after a fork
+static bool g_snapshotScheduled = false;  //!< True once an instance scheduled the snapshot
+static bool g_snapshotTaken = false;  //!< True once the process forked, in the template and the children
+
+/**
+ * \brief Wait for one episode forked from the snapshot
+ * \return true if it exited with status 0
+ */
+static bool
+WaitForBranch (void)
+{
+  int status = 0;
+  pid_t pid;
+  do {
+    pid = waitpid (-1, &status, 0);
+  } while (pid < 0 && errno == EINTR);
+  return pid > 0 && WIFEXITED (status) && WEXITSTATUS (status) == 0;
+}
+
 TypeId DuelingDQNFifoQueueDisc::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::DuelingDQNFifoQueueDisc")
@@ -56,6 +83,22 @@ TypeId DuelingDQNFifoQueueDisc::GetTypeId (void)
                    UintegerValue (2000),
                    MakeUintegerAccessor (&DuelingDQNFifoQueueDisc::m_dequeueThreshold),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("RateEstimator",
+                   "How the dequeue rate used for the queueing delay is estimated",
+                   EnumValue (EWMA_ESTIMATOR),
+                   MakeEnumAccessor (&DuelingDQNFifoQueueDisc::m_rateEstimatorType),
+                   MakeEnumChecker (THRESHOLD_ESTIMATOR, "Threshold",
+                                    EWMA_ESTIMATOR, "Ewma"))
+    .AddAttribute ("RateHalfLife",
+                   "Half-life of the Ewma rate estimator",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&DuelingDQNFifoQueueDisc::m_rateHalfLife),
+                   MakeTimeChecker ())
+    .AddAttribute ("SeedFromDevice",
+                   "Seed the rate estimate with the DataRate of the attached device, if it has one",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&DuelingDQNFifoQueueDisc::m_seedFromDevice),
+                   MakeBooleanChecker ())
     .AddAttribute ("DesiredQueueDelay",
                    "Desired queueing delay",
                    TimeValue (Seconds (2)),
@@ -71,10 +114,127 @@ TypeId DuelingDQNFifoQueueDisc::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&DuelingDQNFifoQueueDisc::m_statusTrigger),
                    MakeBooleanChecker ())
+    .AddAttribute ("Policy",
+                   "Where the buffer sizing decisions come from",
+                   EnumValue (AGENT),
+                   MakeEnumAccessor (&DuelingDQNFifoQueueDisc::m_policy),
+                   MakeEnumChecker (AGENT, "Agent",
+                                    STUB, "Stub",
+                                    NATIVE, "Native"))
+    .AddAttribute ("AgentAddress",
+                   "IPv4 address of the agent server",
+                   StringValue ("127.0.0.1"),
+                   MakeStringAccessor (&DuelingDQNFifoQueueDisc::m_agentAddress),
+                   MakeStringChecker ())
+    .AddAttribute ("AgentPort",
+                   "Port of the agent server",
+                   UintegerValue (8888),
+                   MakeUintegerAccessor (&DuelingDQNFifoQueueDisc::m_agentPort),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("DecisionDeadline",
+                   "Wall-clock budget from sending the state to receiving the action, 0 to wait forever",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&DuelingDQNFifoQueueDisc::m_decisionDeadline),
+                   MakeTimeChecker ())
+    .AddAttribute ("AgentTimeout",
+                   "Wall-clock time after which a late agent is considered hung and the connection is reopened",
+                   TimeValue (Seconds (5)),
+                   MakeTimeAccessor (&DuelingDQNFifoQueueDisc::m_agentTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("FallbackPolicy",
+                   "Policy applied when the agent gives no valid action in time. Stub applies FallbackAction",
+                   EnumValue (STUB),
+                   MakeEnumAccessor (&DuelingDQNFifoQueueDisc::m_fallbackPolicy),
+                   MakeEnumChecker (STUB, "Stub",
+                                    NATIVE, "Native"))
+    .AddAttribute ("FallbackAction",
+                   "Action of the Stub fallback policy: 0 add, 1 keep, 2 reduce",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&DuelingDQNFifoQueueDisc::m_fallbackAction),
+                   MakeUintegerChecker<uint32_t> (0, 2))
+    .AddAttribute ("SnapshotTime",
+                   "Simulated time at which the process forks into episodes sharing the warmed-up state, 0 for none",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&DuelingDQNFifoQueueDisc::m_snapshotTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("SnapshotBranches",
+                   "Number of episodes forked from the snapshot",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&DuelingDQNFifoQueueDisc::m_snapshotBranches),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("SnapshotConcurrency",
+                   "Number of forked episodes running at the same time",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&DuelingDQNFifoQueueDisc::m_snapshotConcurrency),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("BufferTraceFile",
+                   "Prefix of the buffer size trace file, the episode number is appended. Empty for none",
+                   StringValue ("FIFO_Westwood1.5/duelingDQN_FIFO__buffer"),
+                   MakeStringAccessor (&DuelingDQNFifoQueueDisc::m_bufferTraceFile),
+                   MakeStringChecker ())
+    .AddAttribute ("UseEcn",
+                   "Mark ECT packets above the marking threshold instead of waiting for tail drops",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DuelingDQNFifoQueueDisc::m_useEcn),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MarkRatio",
+                   "ECN marking threshold as a fraction of the buffer size chosen by the agent",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&DuelingDQNFifoQueueDisc::m_markRatio),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("SignalPenalty",
+                   "Reward penalty for the fraction of arrivals dropped or marked in a slot, with UseEcn",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&DuelingDQNFifoQueueDisc::m_signalPenalty),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("FlowTableSize",
+                   "Number of entries of the per-flow accounting table, 0 to disable it",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&DuelingDQNFifoQueueDisc::m_flowTableSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("FlowAgeTimeout",
+                   "Idle time after which a flow table entry may be reused by another flow",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&DuelingDQNFifoQueueDisc::m_flowAgeTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("Instrumentation",
+                   "Time the stages of each decision with a monotonic clock",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DuelingDQNFifoQueueDisc::m_instrumentation),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ChromeTraceFile",
+                   "File the decision timeline is written to in Chrome trace format, empty for none",
+                   StringValue (""),
+                   MakeStringAccessor (&DuelingDQNFifoQueueDisc::m_chromeTraceFile),
+                   MakeStringChecker ())
     .AddTraceSource ("SumReward",
                     "the sum reward of one episode",
                     MakeTraceSourceAccessor (&DuelingDQNFifoQueueDisc::trace_rewardSum),
                     "ns3::TracedValueCallback::double")
+    .AddTraceSource ("DecisionStages",
+                     "Wall-clock time of each stage of a decision, fired when Instrumentation is enabled",
+                     MakeTraceSourceAccessor (&DuelingDQNFifoQueueDisc::m_decisionStagesTrace),
+                     "ns3::DuelingDQNFifoQueueDisc::DecisionStagesTracedCallback")
+    .AddTraceSource ("ActiveFlows",
+                     "Number of flows active in the last slot, updated when FlowTableSize is not 0",
+                     MakeTraceSourceAccessor (&DuelingDQNFifoQueueDisc::m_activeFlows),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("JainIndex",
+                     "Jain fairness index of the bytes dequeued per flow in the last slot",
+                     MakeTraceSourceAccessor (&DuelingDQNFifoQueueDisc::m_jainIndex),
+                     "ns3::TracedValueCallback::Double")
+    .AddTraceSource ("MissedDeadlines",
+                     "Number of agent replies that missed DecisionDeadline",
+                     MakeTraceSourceAccessor (&DuelingDQNFifoQueueDisc::m_missedDeadlines),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("Reconnects",
+                     "Number of reconnections to the agent",
+                     MakeTraceSourceAccessor (&DuelingDQNFifoQueueDisc::m_reconnects),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("SnapshotBranch",
+                     "Fired in a process forked from a snapshot, before the episode continues",
+                     MakeTraceSourceAccessor (&DuelingDQNFifoQueueDisc::m_snapshotBranchTrace),
+                     "ns3::DuelingDQNFifoQueueDisc::SnapshotBranchTracedCallback")
   ;
   return tid;
 }
@@ -84,6 +244,7 @@ DuelingDQNFifoQueueDisc::DuelingDQNFifoQueueDisc ()
 {
   NS_LOG_FUNCTION (this);
   count = 0;
+  DRLclient = nullptr;
   
   Simulator::Schedule (Seconds (0.0), &DuelingDQNFifoQueueDisc::createTxt, this);
   
@@ -95,23 +256,56 @@ DuelingDQNFifoQueueDisc::DuelingDQNFifoQueueDisc ()
 DuelingDQNFifoQueueDisc::~DuelingDQNFifoQueueDisc ()
 {
   NS_LOG_FUNCTION (this);
+  g_instances.erase (std::remove (g_instances.begin (), g_instances.end (), this), g_instances.end ());
+  delete DRLclient;
+}
+
+uint32_t
+DuelingDQNFifoQueueDisc::GetDecisionCount (void) const
+{
+  return m_controller.GetDecisionCount ();
+}
+
+double
+DuelingDQNFifoQueueDisc::GetDequeueRate (void) const
+{
+  return m_dequeueRate;
 }
 
 void
 DuelingDQNFifoQueueDisc::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
-  std::cout << std::endl << "Sum of rewards: " << m_rewardsSum << std::endl;
-  trace_rewardSum = (double)m_rewardsSum;
-	std::cout << "Episode " << m_episode << " step count: " << m_episodeStepCount << std::endl;
-	std::cout << "Number of Add action: " << m_addCount << ", Reduce action: " << m_reduceCount << ", Keep action: " << m_keepCount << std::endl << std::endl;
+  std::cout << std::endl << "Sum of rewards: " << m_controller.GetRewardsSum () << std::endl;
+  trace_rewardSum = (double)m_controller.GetRewardsSum ();
+	std::cout << "Episode " << m_episode << " step count: " << m_controller.GetSteps () << std::endl;
+	std::cout << "Number of Add action: " << m_controller.GetActionCount (0) << ", Reduce action: " << m_controller.GetActionCount (2)
+            << ", Keep action: " << m_controller.GetActionCount (1) << std::endl << std::endl;
+  if (m_policy == AGENT)
+    {
+      std::cout << "Fallback decisions: " << m_fallbackCount << ", Missed deadlines: " << m_missedDeadlines.Get ()
+                << ", Reconnects: " << m_reconnects.Get () << std::endl;
+    }
+  if (m_instrumentation)
+    {
+      std::cout << "Decision loop wall-clock time:" << std::endl;
+      m_decisionStats.Summary (std::cout);
+      if (!m_chromeTraceFile.empty () && !m_decisionStats.WriteChromeTrace (m_chromeTraceFile))
+        {
+          NS_LOG_ERROR ("Unable to write Chrome trace file " << m_chromeTraceFile);
+        }
+    }
   double sum = std::accumulate(maxsizeAvg.begin(), maxsizeAvg.end(), 0.0);
   double average = sum / maxsizeAvg.size();
   std::cout<<"The average buffer size: "<<average<<std::endl;
-  DRLstate state1 = {(float)0.0, (float)0.0, (float)0.0, (float)0.0, (float)0.0, true};
-  DRLclient.SendData(&state1);
-  std::cout<<"Train over."<<std::endl;
-  DRLclient.CloseClient();
+  if (DRLclient) {
+    DRLstate state1 = {(float)0.0, (float)0.0, (float)0.0, (float)0.0, (float)0.0, true, {}};
+    DRLclient->SendData(&state1);
+    std::cout<<"Train over."<<std::endl;
+    DRLclient->CloseClient();
+    delete DRLclient;
+    DRLclient = nullptr;
+  }
 
   QueueDisc::DoDispose ();
 	Simulator::Remove (m_eventId);
@@ -120,9 +314,11 @@ DuelingDQNFifoQueueDisc::DoDispose (void)
 
 void
 DuelingDQNFifoQueueDisc::createTxt(void){
-  std::string prefix = "FIFO_Westwood1.5/duelingDQN_FIFO__buffer";
+  if (m_bufferTraceFile.empty ()) {
+    return;
+  }
   std::stringstream ss;
-  ss << prefix << m_episode << ".txt";
+  ss << m_bufferTraceFile << m_episode << ".txt";
   std::string filepath = ss.str();
   std::cout<<filepath<<std::endl;
   cdf_link1::set_output_file(filepath);
@@ -136,19 +332,40 @@ DuelingDQNFifoQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
   if (GetCurrentSize () + item > GetMaxSize ())
     {
       NS_LOG_LOGIC ("Queue full -- dropping pkt");
-      m_droppedPacket++;
+      m_controller.NotifyArrival (false);
+      if (m_flowTableSize > 0)
+        {
+          m_flowTable.NotifyDrop (item->Hash (), Simulator::Now ().GetNanoSeconds ());
+        }
       DropBeforeEnqueue (item, LIMIT_EXCEEDED_DROP);
       
       return false;
     }
-  m_enqueuedPacket++;
+  if (m_controller.ShouldMark (GetCurrentSize ().GetValue ()))
+    {
+      // Non-ECT packets are not marked and only face the hard limit
+      if (Mark (item, MARK_THRESHOLD_EXCEEDED_MARK))
+        {
+          m_controller.NotifyMark ();
+        }
+    }
+  uint32_t hash = m_flowTableSize > 0 ? item->Hash () : 0;
   bool retval = GetInternalQueue (0)->Enqueue (item);
 
-  if(retval && iscongest <5){ //Record the current congestion situation
-    iscongest++;
-  }else if(!retval && iscongest >-5){
-    iscongest--;
-  }
+  if (m_flowTableSize > 0)
+    {
+      uint64_t now = Simulator::Now ().GetNanoSeconds ();
+      if (retval)
+        {
+          m_flowTable.NotifyEnqueue (hash, now);
+        }
+      else
+        {
+          m_flowTable.NotifyDrop (hash, now);
+        }
+    }
+
+  m_controller.NotifyArrival (retval);
 
   // If Queue::Enqueue fails, QueueDisc::DropBeforeEnqueue is called by the
   // internal queue because QueueDisc::AddInternalQueue sets the trace callback
@@ -171,7 +388,12 @@ DuelingDQNFifoQueueDisc::DoDequeue (void)
       NS_LOG_LOGIC ("Queue empty");
       return 0;
     }
-  PacketProcessingRate(item, m_dequeueMeasurement, m_dequeueThreshold, m_dequeueStart, m_dequeueCount, m_dequeueRate);  //Calculate the rate of leaving the queue
+  if (m_flowTableSize > 0)
+    {
+      m_flowTable.NotifyDequeue (item->Hash (), item->GetSize (), Simulator::Now ().GetNanoSeconds ());
+    }
+  m_rateEstimator->Update (Simulator::Now ().GetSeconds (), item->GetSize (), GetInternalQueue (0)->GetNBytes ());  //Calculate the rate of leaving the queue
+  m_dequeueRate = m_rateEstimator->GetRate ();
   return item;
 }
 
@@ -229,31 +451,150 @@ DuelingDQNFifoQueueDisc::InitializeParams (void)
   NS_LOG_FUNCTION (this);
   NS_LOG_INFO ("Initializing DuelingDQNQueueDisc params.");
 
-	m_dequeueRate = 0.0;
-	m_dequeueMeasurement = false;
-	m_dequeueStart = 0;
-	m_dequeueCount = COUNT_INVALID;
+  if (m_rateEstimatorType == THRESHOLD_ESTIMATOR) {
+    m_rateEstimator.reset (new ThresholdRateEstimator (m_dequeueThreshold));
+  }
+  else {
+    m_rateEstimator.reset (new EwmaRateEstimator (m_rateHalfLife.GetSeconds ()));
+  }
+  if (m_seedFromDevice) {
+    SeedRateEstimator ();
+  }
+	m_dequeueRate = m_rateEstimator->GetRate ();
 
 	m_actionTrigger = true;
-	m_currQueueDelay = Seconds(0);
-	m_oldQueueDelay = Seconds(0);
-	m_enqueuedPacket = 0;
-	m_droppedPacket = 0;
-	m_rewardsSum = 0;
 	m_done = false;
 
-	m_episodeStepCount = 0;
-	m_action = 1;
+  m_controller.SetDesiredQueueDelay (m_desiredQueueDelay.GetSeconds ());
+  m_controller.SetEcn (m_useEcn, m_markRatio, m_signalPenalty);
+  m_controller.SetSizeLimits (1, 100);  //The maximum buffer length is 100
+  m_controller.Reset (GetMaxSize ().GetValue ());
+
+  m_flowTable.SetCapacity (m_flowTableSize);
+  m_flowTable.SetAgeTimeout (m_flowAgeTimeout.GetNanoSeconds ());
+  m_activeFlows = 0;
+  m_jainIndex = 1.0;
+
+  m_lastDecisionEnd = 0;
+  m_decisionStats.Reset ();
+  m_decisionStats.EnableTimeline (m_instrumentation && !m_chromeTraceFile.empty ());
+  m_fallbackCount = 0;
+  m_missedDeadlines = 0;
+  m_reconnects = 0;
+  OpenAgentConnection ();
+
+  g_instances.push_back (this);
+  if (m_snapshotTime.IsStrictlyPositive () && !g_snapshotScheduled) {
+    g_snapshotScheduled = true;
+    Time delay = m_snapshotTime - Simulator::Now ();
+    if (delay.IsStrictlyNegative ()) {
+      NS_LOG_WARN ("SnapshotTime " << m_snapshotTime.GetSeconds () << "s has passed, taking the snapshot now");
+      delay = Seconds (0);
+    }
+    Simulator::Schedule (delay, &DuelingDQNFifoQueueDisc::Snapshot, this);
+  }
+}
 
-	m_addCount = 0;
-	m_reduceCount = 0;
-  m_keepCount =0;
-  iscongest = 0;
+void
+DuelingDQNFifoQueueDisc::OpenAgentConnection (void)
+{
+  if (m_policy == AGENT && !DRLclient) {
+    DRLclient = new NS3Client (m_agentAddress.c_str (), m_agentPort);
+    DRLclient->SetStats (m_instrumentation ? &m_decisionStats : nullptr);
+    DRLclient->SetDeadline (m_decisionDeadline.IsStrictlyPositive () ? m_decisionDeadline.GetNanoSeconds () : -1);
+    DRLclient->SetHangTimeout (m_agentTimeout.GetNanoSeconds ());
+  }
+}
+
+void
+DuelingDQNFifoQueueDisc::Snapshot (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (g_snapshotTaken) {
+    return;
+  }
+  g_snapshotTaken = true;
+
+  // Children must not inherit the connections and buffered output of the template
+  for (DuelingDQNFifoQueueDisc* q : g_instances) {
+    q->CloseForSnapshot ();
+  }
+  cdf_link1::close_output_file ();
+  std::cout << "Snapshot at " << Simulator::Now ().GetSeconds () << "s, forking "
+            << m_snapshotBranches << " episodes" << std::endl;
+  std::fflush (0);
+
+  uint32_t running = 0;
+  uint32_t failed = 0;
+  for (uint32_t branch = 1; branch <= m_snapshotBranches; branch++) {
+    if (running >= m_snapshotConcurrency) {
+      failed += WaitForBranch () ? 0 : 1;
+      running--;
+    }
+    pid_t pid = fork ();
+    NS_ABORT_MSG_IF (pid < 0, "Unable to fork the snapshot: " << std::strerror (errno));
+    if (pid == 0) {
+      for (DuelingDQNFifoQueueDisc* q : g_instances) {
+        q->OpenBranch (branch);
+      }
+      return; // The child continues the simulation from here
+    }
+    running++;
+  }
+  while (running > 0) {
+    failed += WaitForBranch () ? 0 : 1;
+    running--;
+  }
+  std::cout << "Snapshot template done, " << failed << " of " << m_snapshotBranches
+            << " episodes failed" << std::endl;
+  std::fflush (0);
+  _exit (failed > 0 ? 1 : 0);  // Skip Simulator::Destroy, the children disposed the episodes
+}
+
+void
+DuelingDQNFifoQueueDisc::CloseForSnapshot (void)
+{
+  if (DRLclient) {
+    DRLclient->CloseClient ();
+    delete DRLclient;
+    DRLclient = nullptr;
+  }
+}
+
+void
+DuelingDQNFifoQueueDisc::OpenBranch (uint32_t branch)
+{
+  NS_LOG_FUNCTION (this << branch);
+  m_episode += branch;
+  if (!m_chromeTraceFile.empty ()) {
+    m_chromeTraceFile += "." + std::to_string (m_episode);
+  }
+
+  // The episode starts at the snapshot, warm-up results belong to the template
+  m_controller.ResetEpisode ();
+  m_fallbackCount = 0;
+  m_missedDeadlines = 0;
+  m_reconnects = 0;
+  maxsizeAvg.clear ();
+  m_lastDecisionEnd = 0;
+  m_decisionStats.Reset ();
+
+  createTxt ();
+  OpenAgentConnection ();
+  m_snapshotBranchTrace (m_episode);
 }
 
 void DuelingDQNFifoQueueDisc::SelectAction(void) {
 
 	if (GetCurrentSize ().GetValue() > 0)  {
+    uint64_t decisionStart = 0;
+    if (m_instrumentation) {
+      decisionStart = DecisionStats::Now ();
+      m_decisionStats.ClearLast ();   //A fallback decision skips some stages
+      if (m_lastDecisionEnd > 0) {
+        m_decisionStats.Record (STAGE_SIMULATE, m_lastDecisionEnd, decisionStart);
+      }
+    }
     if (m_statusTrigger == true) {
       double now = Simulator::Now ().GetSeconds ();
 			std::cout << std::endl << "Current virtual time: " << now << std::endl;
@@ -261,164 +602,118 @@ void DuelingDQNFifoQueueDisc::SelectAction(void) {
 		}
 		m_currState.clear();
 		m_currState = GetObservation(); //Get current state
+    action_t action = 1;
     
-    DRLstate state1 = {(float)m_currState[0], (float)m_currState[1], (float)m_currState[2], (float)m_currState[3], 
-    (float)m_singleReward, false};
-    DRLclient.SendData(&state1);  //Send to RL algorithm
-    m_action =DRLclient.RecvData();   //Recive action from RL algorithm
-
-    if(m_action==0){
-        AddByDQN();
-        m_addCount++;
+    if (m_policy == AGENT) {
+      DRLstate state1 = {(float)m_currState[0], (float)m_currState[1], (float)m_currState[2], (float)m_currState[3], 
+      m_controller.GetLastReward (), false,
+      std::vector<float>(m_currState.begin() + 4, m_currState.end())};  //Optional features
+      float reply = -1;
+      bool sent = DRLclient->SendData(&state1);   //Send to RL algorithm and receive the action
+      bool received = DRLclient->RecvData(reply);   //Called even if not sent, so that every stage is timed
+      if (sent && received && reply >= 0 && reply <= 2) {
+        action = (action_t)reply;
+      }
+      else {
+        action = FallbackAction(m_currState);
+      }
+      m_missedDeadlines = DRLclient->GetMissedDeadlines();
+      m_reconnects = DRLclient->GetReconnects();
+      if (DRLclient->TakeSnapshotRequest()) {
+        Simulator::ScheduleNow (&DuelingDQNFifoQueueDisc::Snapshot, this);
+      }
     }
-    else if(m_action==1){
-        KeepByDQN();
-        m_keepCount++;
+    else if (m_policy == NATIVE) {
+      action = m_controller.NativeAction(m_currState);
     }
-    else if(m_action==2){
-        DropByDQN();
-        m_reduceCount++;
+
+    uint32_t maxSize = m_controller.ApplyAction(action, GetMaxSize().GetValue(), GetInternalQueue(0)->GetNPackets());
+    SetMaxSize(QueueSize(QueueSizeUnit::PACKETS, maxSize));
+    if (m_instrumentation) {
+      RecordDecision (decisionStart);
     }
 		m_actionTrigger = false;	// Set trigger false before going to next state
-		m_enqueuedPacket = 0;
-		m_droppedPacket = 0;
-		m_oldQueueDelay = m_currQueueDelay;
+    if (m_flowTableSize > 0) {
+      m_flowTable.NewSlot();
+    }
 		m_eventId = Simulator::Schedule (m_updatePeriod, &DuelingDQNFifoQueueDisc::CalculateRewards, this); //Calculate reward after slot time
 
 	}
+  else if (m_flowTableSize > 0) {   //No decision, the flow slot ends all the same
+    m_flowTable.NewSlot();
+  }
 
 	if (m_actionTrigger == true) {	// Keep checking if queue delay is 0
 		m_eventId = Simulator::Schedule (m_updatePeriod, &DuelingDQNFifoQueueDisc::SelectAction, this);
 	}
 }
 
-void DuelingDQNFifoQueueDisc::DropByDQN(void) {
-
-  uint32_t currentQueueSize = GetInternalQueue(0)->GetNPackets();
-  uint32_t maxSize = QueueDisc::GetMaxSize().GetValue();
-
-  uint32_t newMaxSize = maxSize-1 >= currentQueueSize ? maxSize-1 : currentQueueSize; //Pay attention to queue length when reducing buffer size
-  newMaxSize = newMaxSize >= 1? newMaxSize : 1; //Pay attention to minimum buffer size
-  std::string _pkt_max = std::to_string(newMaxSize) + "p";
-  QueueDisc::SetMaxSize(QueueSize(_pkt_max));    
+void DuelingDQNFifoQueueDisc::RecordDecision(uint64_t start) {
+  m_lastDecisionEnd = DecisionStats::Now ();
+  m_decisionStats.Record (STAGE_DECISION, start, m_lastDecisionEnd);
+  m_decisionStagesTrace (NanoSeconds (m_decisionStats.GetLast (STAGE_SIMULATE)),
+                         NanoSeconds (m_decisionStats.GetLast (STAGE_SERIALIZE)),
+                         NanoSeconds (m_decisionStats.GetLast (STAGE_SEND)),
+                         NanoSeconds (m_decisionStats.GetLast (STAGE_AGENT)),
+                         NanoSeconds (m_decisionStats.GetLast (STAGE_PARSE)),
+                         NanoSeconds (m_decisionStats.GetLast (STAGE_DECISION)));
 }
 
-void DuelingDQNFifoQueueDisc::KeepByDQN(void) {
-
-    uint32_t maxSize = QueueDisc::GetMaxSize().GetValue();
-    uint32_t newMaxSize = maxSize;
-    std::string _pkt_max = std::to_string(newMaxSize) + "p";
-    QueueDisc::SetMaxSize(QueueSize(_pkt_max));
-}
-
-void DuelingDQNFifoQueueDisc::AddByDQN(void) {
-
-  uint32_t maxSize = QueueDisc::GetMaxSize().GetValue();
-
-  uint32_t newMaxSize = maxSize+1 <= 100 ? maxSize+1 : 100; //The maximum buffer length is 100
-
-  std::string _pkt_max = std::to_string(newMaxSize) + "p";
-  QueueDisc::SetMaxSize(QueueSize(_pkt_max));
+action_t DuelingDQNFifoQueueDisc::FallbackAction(const observation_t& ob) {
+  m_fallbackCount++;
+  if (m_fallbackPolicy == NATIVE) {
+    return m_controller.NativeAction(ob);
+  }
+  return m_fallbackAction;
 }
 
-void DuelingDQNFifoQueueDisc::PacketProcessingRate(Ptr<QueueDiscItem>& item, bool& measurement, uint32_t& threshold, double& start, uint64_t& count, double& rate) {	
-	// Measure en/dequeue rate after processing the item
-	double now = Simulator::Now ().GetSeconds ();
-	uint32_t pktSize = item->GetSize();
-
-	if ((GetInternalQueue (0)->GetNBytes () >= threshold) && (!measurement)) {
-		start = now;
-		count = 0;
-		measurement = true;
-	}
-	if (measurement) {
-		count += pktSize;
-
-		if (count >= threshold) {
-			double tmp = now - start;
-
-			if (tmp > 0) {
-				if (rate == 0) {
-					rate = (double)count / tmp;
-				}
-				else {	// Proportion of old/new processing rate can be changed
-					rate = (0.5 * rate) + (0.5 * (count / tmp));
-				}
-			}
-			// Restart a measurement cycle if number of packets in queue exceeds the threshold
-			if (GetInternalQueue (0)->GetNBytes () > threshold) {
-				start = now;
-				count = 0;
-				measurement = true;
-			}
-			else {
-				count = 0;
-				measurement = false;
-			}
-		}
-	}
+void DuelingDQNFifoQueueDisc::SeedRateEstimator(void) {
+  Ptr<NetDeviceQueueInterface> ndqi = GetNetDeviceQueueInterface ();
+  Ptr<NetDevice> device = ndqi ? ndqi->GetObject<NetDevice> () : 0;
+  DataRateValue rate;
+  if (device && device->GetAttributeFailSafe ("DataRate", rate)) {
+    NS_LOG_INFO ("Seeding the dequeue rate with " << rate.Get ());
+    m_rateEstimator->Seed (rate.Get ().GetBitRate () / 8.0);
+  }
 }
 
 void DuelingDQNFifoQueueDisc::CalculateRewards(void) {
   if (m_statusTrigger == true)
       std::cout << std::endl << "*** Rewards ***" << std::endl;
 
-  if (m_dequeueRate > 0) {
-		m_currQueueDelay = Time (Seconds (GetInternalQueue (0)->GetNBytes () / m_dequeueRate));
-	}
-	else {
-		m_currQueueDelay = Time (Seconds(0));
-	}
-
-  if(iscongest <= 0){
-    m_singleReward = (float)m_currQueueDelay.GetSeconds() / m_desiredQueueDelay.GetSeconds () ;
-  }else{
-    m_singleReward = (float)GetInternalQueue (0)->GetNPackets() / maxSize;
-  }
-
-  m_singleReward = std::max((float)-1.0, m_singleReward);   // Clipped by min / max value
-  m_singleReward = std::min((float)1.0, m_singleReward);
+  float reward = m_controller.CalculateReward (GetInternalQueue (0)->GetNPackets (), GetInternalQueue (0)->GetNBytes (),
+                                               GetMaxSize ().GetValue (), *m_rateEstimator);
+  m_dequeueRate = m_rateEstimator->GetRate ();
 
   if (m_statusTrigger == true) {
-    std::cout << "reward: " << m_singleReward << std::endl << std::endl;;
+    std::cout << "reward: " << reward << std::endl << std::endl;;
   }
 
-  m_rewardsSum += m_singleReward;
-  m_episodeStepCount++;   // Increment of step count
-
-  if ( (m_currQueueDelay.GetSeconds () < 0.5 * m_desiredQueueDelay.GetSeconds ()) && 
-    (m_oldQueueDelay.GetSeconds () < (0.5 * m_desiredQueueDelay.GetSeconds ())) && 
-    (m_action == 1) && 
-    (m_dequeueRate > 0)) {
-    m_dequeueCount = COUNT_INVALID;
-    m_dequeueRate = 0.0;
-  }
-
-  m_action = 1;
   m_actionTrigger = true;
   m_eventId = Simulator::Schedule (NanoSeconds(0), &DuelingDQNFifoQueueDisc::SelectAction, this);
 }
 
 observation_t DuelingDQNFifoQueueDisc::GetObservation(void) {
-	observation_t ob;
-
-	if (m_dequeueRate > 0) {
-		m_currQueueDelay = Time (Seconds (GetInternalQueue (0)->GetNBytes () / m_dequeueRate));
-	}
-	else {
-		m_currQueueDelay = Time (Seconds(0));
-	}
   uint32_t maxSize = QueueDisc::GetMaxSize().GetValue();
-	ob.push_back(GetCurrentSize ().GetValue());
-	ob.push_back(m_dequeueRate * 8 / 1e+6);	// Convert to Mbps
-	ob.push_back(m_currQueueDelay.GetSeconds());
-	ob.push_back(maxSize);
-	
+  if (m_flowTableSize > 0) {  //Per-flow features of the slot that just ended
+    m_activeFlows = m_flowTable.GetActiveFlows();
+    m_jainIndex = m_flowTable.GetJainIndex();
+  }
+	observation_t ob = m_controller.GetObservation(GetCurrentSize ().GetValue(), GetInternalQueue (0)->GetNBytes (), maxSize,
+                                                m_dequeueRate, m_flowTableSize > 0 ? &m_flowTable : nullptr);
+
 	if (m_statusTrigger == true) {
 		std::cout << "Current queue size in packet: " << GetCurrentSize ().GetValue() << "p" << std::endl;
 		std::cout << "dequeue rate: " << m_dequeueRate * 8 / 1e+6 << "Mbps" << std::endl;
-		std::cout << "Current queue delay: " << m_currQueueDelay.GetSeconds() << "s" << std::endl;
+		std::cout << "Current queue delay: " << m_controller.GetQueueDelay() << "s" << std::endl;
     std::cout << "Current maxSize: " << maxSize << "p"<< std::endl;
+    if (m_flowTableSize > 0) {
+      std::cout << "Active flows: " << m_activeFlows.Get() << ", Jain index: " << m_jainIndex.Get() << std::endl;
+    }
+    if (m_useEcn) {
+      std::cout << "Dropped: " << m_controller.GetSlotDrops() << ", Marked: " << m_controller.GetSlotMarks()
+                << ", Marking threshold: " << m_controller.GetMarkThreshold() << std::endl;
+    }
 	}
 
 	return ob;
@@ -26,6 +26,7 @@
 #include "ns3/nstime.h"
 #include "ns3/boolean.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/traced-callback.h"
 
 #include "ns3/timer.h"
 #include "ns3/event-id.h"
@@ -36,11 +37,9 @@
 #include <algorithm>
 #include <cmath>
 #include <random>
+#include <memory>
 #include "ns3/ns3socket-module.h"
 
-using action_t = uint32_t;
-using observation_t = std::vector<double>;
-
 namespace ns3 {
 
 static std::string m_cdf_outputFileName1; ///< output file name
@@ -79,6 +78,16 @@ public:
     return;
   }
 
+  static void close_output_file (void)
+  {
+    if (m_cdf_f1)
+      {
+        std::fclose (m_cdf_f1);
+      }
+    m_cdf_f1 = 0;
+    m_cdf_outputFileName1 = "";
+  }
+
   static  int  WriteN (const char* data, uint32_t count, FILE * f)
   {
     if (!f)
@@ -148,8 +157,70 @@ public:
 
   virtual ~DuelingDQNFifoQueueDisc();
 
+  /**
+   * TracedCallback signature for the wall-clock time of each decision stage.
+   *
+   * \param [in] simulate Simulation since the previous decision
+   * \param [in] serialize State serialization
+   * \param [in] send Sending the state to the agent
+   * \param [in] agent Waiting for the agent reply
+   * \param [in] parse Parsing the action
+   * \param [in] decision The whole decision
+   */
+  typedef void (* DecisionStagesTracedCallback)(Time simulate, Time serialize, Time send,
+                                                Time agent, Time parse, Time decision);
+
+  /**
+   * TracedCallback signature for a new episode forked from a snapshot.
+   *
+   * \param [in] episode The episode number of the forked process
+   */
+  typedef void (* SnapshotBranchTracedCallback)(uint32_t episode);
+
+  /**
+   * \brief Where the buffer sizing decisions come from
+   */
+  enum DecisionPolicy
+  {
+    AGENT,  //!< Remote RL agent over NS3Client
+    STUB,   //!< Always keep the buffer size, no agent needed
+    NATIVE  //!< Embedded delay/drop heuristic, no agent needed
+  };
+
+  /**
+   * \brief Dequeue rate estimators
+   */
+  enum RateEstimatorType
+  {
+    THRESHOLD_ESTIMATOR,  //!< ThresholdRateEstimator, measures once DequeueThreshold bytes are queued
+    EWMA_ESTIMATOR        //!< EwmaRateEstimator, decaying byte counter seeded with the link rate
+  };
+
+  /**
+   * \return the number of decisions taken so far
+   */
+  uint32_t GetDecisionCount (void) const;
+  /**
+   * \return the estimated dequeue rate in bytes/s
+   */
+  double GetDequeueRate (void) const;
+
+  /**
+   * \brief Freeze the simulation as a template and run episodes forked from it
+   *
+   * Process-wide: the first call closes the agent connections and trace
+   * files of all DuelingDQNFifoQueueDisc instances and forks SnapshotBranches
+   * children. Each child continues the simulation as episode Episode + n,
+   * reopening its own agent connection and trace files and firing
+   * SnapshotBranch. The template waits for the children and exits, it never
+   * returns. Later calls do nothing.
+   */
+  void Snapshot (void);
+
   // Reasons for dropping packets
   static constexpr const char* LIMIT_EXCEEDED_DROP = "Queue disc limit exceeded";  //!< Packet dropped due to queue disc limit exceeded
+  // Reasons for marking packets
+  static constexpr const char* MARK_THRESHOLD_EXCEEDED_MARK = "Marking threshold exceeded";  //!< ECT packet marked above the marking threshold
 
 protected:
   /**
@@ -164,53 +235,72 @@ private:
   virtual bool CheckConfig (void);
   virtual void InitializeParams (void);
 
-  void DropByDQN(void); //Reduce Queue Maxsize
-  void AddByDQN(void);  //Add Queue Maxsize
-  void KeepByDQN(void); //Maintain Queue Maxsize
   void CalculateRewards(void);
   void createTxt (void);
-  void PacketProcessingRate(Ptr<QueueDiscItem>& item, bool& measurement, uint32_t& threshold, double& start, uint64_t& count, double& rate);  //Measure en/dequeue rate
+  void SeedRateEstimator(void);  //Seed the dequeue rate from the attached device
   
   void track_queue_length();  //Record queue length
   EventId m_eventId;
   void SelectAction(void);
+  void RecordDecision(uint64_t start); //Record stage latencies of one decision
+  action_t FallbackAction(const observation_t& ob); //Action when the agent misses its deadline
+  void OpenAgentConnection(void); //Create the agent client for the AGENT policy
+  void CloseForSnapshot(void);  //Release the per-episode resources in the template
+  void OpenBranch(uint32_t branch); //Start episode Episode + branch in a forked child
   observation_t GetObservation(void); //Get state
 
   uint32_t m_dequeueThreshold;
+  RateEstimatorType m_rateEstimatorType;
+  Time m_rateHalfLife;  // Half-life of the EWMA byte counter
+  bool m_seedFromDevice;  // Seed the rate estimate with the device DataRate
+  std::unique_ptr<RateEstimator> m_rateEstimator;
   Time m_updatePeriod;  // Slot time
   Time m_desiredQueueDelay;
   uint32_t m_episode;
   bool m_statusTrigger;
   uint32_t count;
   bool m_actionTrigger;
-  Time m_currQueueDelay;
-  Time m_oldQueueDelay;
-  uint32_t m_enqueuedPacket;  // Number of enqueued packets in queue within update period
-  uint32_t m_droppedPacket; // Number of dropped packets in queue within update period
+  BufferController m_controller;  // Slot counters, observation, reward and actions
+  bool m_useEcn;  // True to mark ECT packets above the marking threshold
+  double m_markRatio; // Marking threshold as a fraction of the buffer size
+  double m_signalPenalty; // Reward penalty per dropped or marked fraction of arrivals
   bool m_done;  // True if simulation is done
-  action_t m_action;  // Selected action
-  float m_singleReward; // Rewards generated by single action
-  float m_rewardsSum; // Sum of rewards
-  uint32_t m_episodeStepCount;  //Count step for actions
 
-  double m_dequeueRate;
+  double m_dequeueRate;  // Dequeue rate in bytes/s, as given by m_rateEstimator
   observation_t m_currState;  //Current state
 
-  uint64_t m_dequeueCount;
-  static const uint64_t COUNT_INVALID = std::numeric_limits<uint64_t>::max();	// invalid packet count value
+  TracedValue<double> trace_rewardSum;
 
-  bool m_dequeueMeasurement;
-  double m_dequeueStart;
+  bool m_instrumentation; // True to time the stages of each decision
+  std::string m_chromeTraceFile;  // Chrome trace output of the decision timeline, empty for none
+  DecisionStats m_decisionStats;  // Per-stage latency counters and histograms
+  uint64_t m_lastDecisionEnd; // Monotonic time the previous decision finished, 0 if none
+  TracedCallback<Time, Time, Time, Time, Time, Time> m_decisionStagesTrace;
 
-  TracedValue<double> trace_rewardSum;
+  uint32_t m_flowTableSize; // Entries of the per-flow table, 0 to disable it
+  Time m_flowAgeTimeout;  // Idle time after which a flow entry may be reused
+  FlowTable m_flowTable;  // Per-flow bytes and drops
+  TracedValue<uint32_t> m_activeFlows;  // Flows active in the last slot
+  TracedValue<double> m_jainIndex;  // Jain fairness index of the last slot
   
   std::vector<uint32_t> maxsizeAvg;
-  NS3Client DRLclient;  //Socket client
+  DecisionPolicy m_policy; // Source of the decisions
+  std::string m_bufferTraceFile;  // Prefix of the buffer size trace, empty for none
+  NS3Client* DRLclient;  //Socket client, only connected for the AGENT policy
+  std::string m_agentAddress; // Address of the agent server
+  uint16_t m_agentPort; // Port of the agent server
+  Time m_decisionDeadline;  // Wall-clock budget of an agent decision, 0 to wait forever
+  Time m_agentTimeout;  // Reconnect when a reply is this late
+  DecisionPolicy m_fallbackPolicy;  // Policy applied when the agent gives no action
+  uint32_t m_fallbackAction;  // Action applied by the STUB fallback policy
+  uint32_t m_fallbackCount; // Decisions taken by the fallback policy
+  TracedValue<uint32_t> m_missedDeadlines;  // Agent replies that missed the deadline
+  TracedValue<uint32_t> m_reconnects; // Reconnections to the agent
 
-  uint32_t m_addCount;	// Number of add action
-  uint32_t m_reduceCount; // Number of reduce action
-  uint32_t m_keepCount; // Number of maintain action
-  uint32_t iscongest; //Congestion level
+  Time m_snapshotTime;  // Simulated time of the snapshot, 0 for none
+  uint32_t m_snapshotBranches;  // Episodes forked from the snapshot
+  uint32_t m_snapshotConcurrency; // Forked episodes running at the same time
+  TracedCallback<uint32_t> m_snapshotBranchTrace;
 };
 
 } // namespace ns3
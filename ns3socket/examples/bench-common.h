@@ -0,0 +1,207 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef NS3SOCKET_BENCH_COMMON_H
+#define NS3SOCKET_BENCH_COMMON_H
+
+// Shared setup and reporting of the scenario benchmark programs.
+//
+// Every scenario installs DuelingDQNFifoQueueDisc, or one of its
+// specialized variants with --queueDisc, on its bottleneck links, seeds the
+// RNG from the command line and prints the same report, so the numbers of
+// different runs, revisions and variants can be compared directly.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/traffic-control-module.h"
+#include "ns3/fifo-duelingDQN-queue-disc.h"
+#include "ns3/fifo-duelingDQN-queue-disc-specialized.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sys/resource.h>
+
+namespace ns3 {
+
+/**
+ * Command line options common to all scenarios.
+ */
+struct BenchOptions
+{
+  uint32_t seed = 1;            //!< RngSeedManager seed
+  uint32_t run = 1;             //!< RngSeedManager run number
+  double simTime = 10.0;        //!< Simulated seconds
+  std::string policy = "Stub";  //!< DuelingDQNFifoQueueDisc::Policy
+  std::string maxSize = "50p";  //!< Initial bottleneck buffer size
+  std::string tcp = "ns3::TcpNewReno";  //!< TCP congestion control
+  bool ecn = false;             //!< ECN-capable TCP and marking in the queue discs
+  std::string queueDisc = "ns3::DuelingDQNFifoQueueDisc";  //!< Bottleneck queue disc TypeId
+
+  void AddValues (CommandLine& cmd)
+  {
+    cmd.AddValue ("seed", "RNG seed", seed);
+    cmd.AddValue ("run", "RNG run number", run);
+    cmd.AddValue ("simTime", "Simulated time in seconds", simTime);
+    cmd.AddValue ("policy", "Decision policy of the queue disc: Agent, Stub or Native", policy);
+    cmd.AddValue ("maxSize", "Initial buffer size of the bottleneck queue discs", maxSize);
+    cmd.AddValue ("tcp", "TCP congestion control TypeId", tcp);
+    cmd.AddValue ("ecn", "Enable ECN in TCP and marking in the queue discs", ecn);
+    cmd.AddValue ("queueDisc", "Bottleneck queue disc TypeId, e.g. ns3::DuelingDQNFifoQueueDisc<Packets,Base,Native,Untimed>",
+                  queueDisc);
+  }
+
+  /**
+   * Apply the options. Call after CommandLine::Parse and before building the topology.
+   */
+  void Apply (void) const
+  {
+    RngSeedManager::SetSeed (seed);
+    RngSeedManager::SetRun (run);
+    Config::SetDefault ("ns3::TcpL4Protocol::SocketType", StringValue (tcp));
+    Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1448));
+    Config::SetDefault ("ns3::DuelingDQNFifoQueueDisc::Policy", StringValue (policy));
+    Config::SetDefault ("ns3::DuelingDQNFifoQueueDisc::BufferTraceFile", StringValue (""));
+    if (ecn)
+      {
+        Config::SetDefault ("ns3::TcpSocketBase::UseEcn", StringValue ("On"));
+        Config::SetDefault ("ns3::DuelingDQNFifoQueueDisc::UseEcn", BooleanValue (true));
+      }
+  }
+
+  /**
+   * \return a helper installing the bottleneck queue disc with the configured initial size
+   */
+  TrafficControlHelper GetBottleneckHelper (void) const
+  {
+    TrafficControlHelper tch;
+    tch.SetRootQueueDisc (queueDisc, "MaxSize", StringValue (maxSize));
+    return tch;
+  }
+};
+
+/**
+ * \param rate the link data rate
+ * \param delay the link delay
+ * \return a point-to-point helper with a one-packet device queue, so that the
+ *         queue disc holds the whole buffer
+ */
+inline PointToPointHelper
+MakeLink (std::string rate, std::string delay)
+{
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue (rate));
+  p2p.SetChannelAttribute ("Delay", StringValue (delay));
+  p2p.SetQueue ("ns3::DropTailQueue", "MaxSize", StringValue ("1p"));
+  return p2p;
+}
+
+/**
+ * Install a bulk TCP flow from src to the sink at dst:port.
+ *
+ * \param src the sender
+ * \param dst the receiver
+ * \param dstAddr the address of dst
+ * \param port the destination port, unique per flow on dst
+ * \param start when the flow starts
+ * \param stop when the flow stops
+ * \param maxBytes bytes to send, 0 for unlimited
+ */
+inline void
+InstallBulkFlow (Ptr<Node> src, Ptr<Node> dst, Ipv4Address dstAddr, uint16_t port,
+                 Time start, Time stop, uint64_t maxBytes = 0)
+{
+  BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (dstAddr, port));
+  source.SetAttribute ("MaxBytes", UintegerValue (maxBytes));
+  ApplicationContainer sourceApp = source.Install (src);
+  sourceApp.Start (start);
+  sourceApp.Stop (stop);
+
+  PacketSinkHelper sink ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+  ApplicationContainer sinkApp = sink.Install (dst);
+  sinkApp.Start (start);
+  sinkApp.Stop (stop);
+}
+
+/**
+ * Run the simulation and print the performance report of a scenario.
+ */
+class ScenarioBenchmark
+{
+public:
+  ScenarioBenchmark (std::string name)
+    : m_name (name)
+  {
+  }
+
+  void AddQueueDiscs (const QueueDiscContainer& qdiscs)
+  {
+    m_qdiscs.Add (qdiscs);
+  }
+
+  /**
+   * \brief Run until stop, print the report and destroy the simulator
+   * \param stop the simulated stop time
+   */
+  void Run (Time stop)
+  {
+    Simulator::Stop (stop);
+
+    uint64_t eventsBefore = Simulator::GetEventCount ();
+    auto wallStart = std::chrono::steady_clock::now ();
+    Simulator::Run ();
+    auto wallEnd = std::chrono::steady_clock::now ();
+    uint64_t events = Simulator::GetEventCount () - eventsBefore;
+
+    uint64_t decisions = 0;
+    for (auto it = m_qdiscs.Begin (); it != m_qdiscs.End (); ++it)
+      {
+        Ptr<DuelingDQNFifoQueueDisc> q = DynamicCast<DuelingDQNFifoQueueDisc> (*it);
+        Ptr<SpecializedDuelingDQNQueueDisc> sq = DynamicCast<SpecializedDuelingDQNQueueDisc> (*it);
+        if (q)
+          {
+            decisions += q->GetDecisionCount ();
+          }
+        else if (sq)
+          {
+            decisions += sq->GetDecisionCount ();
+          }
+      }
+
+    double wall = std::chrono::duration<double> (wallEnd - wallStart).count ();
+    double sim = Simulator::Now ().GetSeconds ();
+    struct rusage usage;
+    getrusage (RUSAGE_SELF, &usage);
+
+    std::ios_base::fmtflags flags = std::cout.flags ();
+    std::streamsize precision = std::cout.precision ();
+    std::cout << std::fixed << std::setprecision (3)
+              << "=== " << m_name << " ===" << std::endl
+              << "Queue discs: " << m_qdiscs.GetN ();
+    if (m_qdiscs.GetN () > 0)
+      {
+        std::cout << " " << m_qdiscs.Get (0)->GetInstanceTypeId ().GetName ();
+      }
+    std::cout << std::endl
+              << "Simulated time: " << sim << " s" << std::endl
+              << "Wall-clock time: " << wall << " s" << std::endl
+              << "Simulated s per wall-clock s: " << sim / wall << std::endl
+              << "Events: " << events << " (" << events / wall << " events/s)" << std::endl
+              << "Decisions: " << decisions << " (" << decisions / wall << " decisions/s)" << std::endl
+              // ru_maxrss is in KiB on Linux
+              << "Peak RSS: " << usage.ru_maxrss / 1024.0 << " MiB" << std::endl;
+    std::cout.flags (flags);
+    std::cout.precision (precision);
+
+    Simulator::Destroy ();
+  }
+
+private:
+  std::string m_name;
+  QueueDiscContainer m_qdiscs;
+};
+
+} // namespace ns3
+
+#endif /* NS3SOCKET_BENCH_COMMON_H */
@@ -0,0 +1,313 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+// Microbenchmark of the buffer control hot paths
+//
+// Drives the per-packet (enqueue/dequeue) and per-slot (observe, decide,
+// apply, reward) control work in two forms over the same packet sequence:
+//
+//  - runtime: BufferController, a virtual RateEstimator, an optional
+//    FlowTable and the runtime flag checks, in a copy of the calls that
+//    DuelingDQNFifoQueueDisc makes
+//  - specialized: BufferControlCore with the same configuration fixed at
+//    compile time, as SpecializedDuelingDQNFifoQueueDisc uses it
+//
+// Neither queue disc is run: the internal queue is a plain deque in both
+// forms and there is no QueueDisc, Packet or Simulator overhead, so the
+// ratios say nothing about the speed of the queue discs themselves. Run a
+// scenario benchmark once per --queueDisc for that. The decisions use the
+// native policy, an agent round trip would dominate both.
+
+#include "ns3/core-module.h"
+#include "ns3/ns3socket-module.h"
+
+#include <chrono>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace ns3;
+
+namespace {
+
+struct Packet
+{
+  uint32_t size;
+  uint32_t hash;
+};
+
+/**
+ * A copy of the control calls of DuelingDQNFifoQueueDisc with its runtime
+ * configuration, kept in line with the queue disc by hand
+ */
+class RuntimeControl
+{
+public:
+  RuntimeControl (bool flows, bool ecn)
+    : m_estimator (new EwmaRateEstimator (0.01)),
+      m_flowTableSize (flows ? 1024 : 0),
+      m_useEcn (ecn),
+      m_statusTrigger (false),
+      m_native (true),
+      m_limit (50),
+      m_bytes (0),
+      m_dequeueRate (0)
+  {
+    m_estimator->Seed (1.25e8);
+    m_flowTable.SetCapacity (m_flowTableSize);
+    m_controller.SetEcn (m_useEcn, 0.5, 0.5);
+    m_controller.SetDesiredQueueDelay (0.0002);
+    m_controller.Reset (m_limit);
+  }
+
+  bool Enqueue (const Packet& p, uint64_t now)
+  {
+    if (m_queue.size () + 1 > m_limit)
+      {
+        m_controller.NotifyArrival (false);
+        if (m_flowTableSize > 0)
+          {
+            m_flowTable.NotifyDrop (p.hash, now);
+          }
+        return false;
+      }
+    if (m_controller.ShouldMark (m_queue.size ()))
+      {
+        m_controller.NotifyMark ();
+      }
+    m_queue.push_back (p);
+    m_bytes += p.size;
+    if (m_flowTableSize > 0)
+      {
+        m_flowTable.NotifyEnqueue (p.hash, now);
+      }
+    m_controller.NotifyArrival (true);
+    return true;
+  }
+
+  void Dequeue (uint64_t now)
+  {
+    if (m_queue.empty ())
+      {
+        return;
+      }
+    Packet p = m_queue.front ();
+    m_queue.pop_front ();
+    m_bytes -= p.size;
+    if (m_flowTableSize > 0)
+      {
+        m_flowTable.NotifyDequeue (p.hash, p.size, now);
+      }
+    m_estimator->Update (now * 1e-9, p.size, m_bytes);
+    m_dequeueRate = m_estimator->GetRate ();
+  }
+
+  float Decide (void)
+  {
+    if (m_statusTrigger)
+      {
+        std::cout << "*** Current State ***" << std::endl;
+      }
+    observation_t ob = m_controller.GetObservation (m_queue.size (), m_bytes, m_limit, m_dequeueRate,
+                                                    m_flowTableSize > 0 ? &m_flowTable : nullptr);
+    action_t action = m_native ? m_controller.NativeAction (ob) : 1;
+    m_limit = m_controller.ApplyAction (action, m_limit, m_queue.size ());
+    if (m_flowTableSize > 0)
+      {
+        m_flowTable.NewSlot ();
+      }
+    float reward = m_controller.CalculateReward (m_queue.size (), m_bytes, m_limit, *m_estimator);
+    m_dequeueRate = m_estimator->GetRate ();
+    return reward;
+  }
+
+  uint32_t GetDecisionCount (void) const
+  {
+    return m_controller.GetDecisionCount ();
+  }
+
+private:
+  BufferController m_controller;
+  std::unique_ptr<RateEstimator> m_estimator;
+  FlowTable m_flowTable;
+  uint32_t m_flowTableSize;
+  bool m_useEcn;
+  bool m_statusTrigger;
+  bool m_native;
+  uint32_t m_limit;
+  std::deque<Packet> m_queue;
+  uint32_t m_bytes;
+  double m_dequeueRate;
+};
+
+/**
+ * The same work on a BufferControlCore
+ */
+template <class Schema, class Policy>
+class SpecializedControl
+{
+public:
+  typedef BufferControlCore<PacketSizing, Schema> Core;
+
+  SpecializedControl (bool, bool)
+    : m_core (EwmaRateEstimator (0.01)),
+      m_bytes (0)
+  {
+    m_core.GetEstimator ().Seed (1.25e8);
+    m_core.SetFlowTable (1024, 1000000000);
+    m_core.SetEcn (0.5, 0.5);
+    m_core.SetDesiredQueueDelay (0.0002);
+    m_core.Reset (50);
+  }
+
+  bool Enqueue (const Packet& p, uint64_t now)
+  {
+    if (!m_core.Admit (m_queue.size (), m_bytes, p.size, p.hash, now))
+      {
+        return false;
+      }
+    if (m_core.ShouldMark (m_queue.size (), m_bytes))
+      {
+        m_core.NotifyMark ();
+      }
+    m_queue.push_back (p);
+    m_bytes += p.size;
+    m_core.NotifyEnqueue (true, p.hash, now);
+    return true;
+  }
+
+  void Dequeue (uint64_t now)
+  {
+    if (m_queue.empty ())
+      {
+        return;
+      }
+    Packet p = m_queue.front ();
+    m_queue.pop_front ();
+    m_bytes -= p.size;
+    m_core.NotifyDequeue (p.size, p.hash, now, m_bytes);
+  }
+
+  float Decide (void)
+  {
+    typename Core::Observation ob;
+    m_core.Observe (m_queue.size (), m_bytes, ob);
+    m_core.ApplyAction (m_policy.Decide (m_core, ob), m_queue.size (), m_bytes);
+    return m_core.CalculateReward (m_queue.size (), m_bytes);
+  }
+
+  uint32_t GetDecisionCount (void) const
+  {
+    return m_core.GetDecisionCount ();
+  }
+
+private:
+  Core m_core;
+  Policy m_policy;
+  std::deque<Packet> m_queue;
+  uint32_t m_bytes;
+};
+
+struct Result
+{
+  double packetNs;    //!< Best wall-clock ns per enqueue/dequeue pair
+  double decisionNs;  //!< Best wall-clock ns per decision
+  double checksum;    //!< Keeps the work observable
+};
+
+template <class Control>
+Result
+Measure (const std::vector<Packet>& packets, uint32_t nPackets, uint32_t nDecisions, uint32_t repeat,
+         bool flows, bool ecn)
+{
+  Result result = {1e30, 1e30, 0};
+  for (uint32_t r = 0; r < repeat; r++)
+    {
+      Control control (flows, ecn);
+      uint64_t now = 0;
+      uint64_t accepted = 0;
+
+      // 8 arrivals per 7 departures keep the queue at its limit with a few drops
+      auto start = std::chrono::steady_clock::now ();
+      for (uint32_t i = 0; i < nPackets; i++)
+        {
+          now += 96;
+          accepted += control.Enqueue (packets[i % packets.size ()], now);
+          if (i % 8 != 7)
+            {
+              control.Dequeue (now);
+            }
+        }
+      auto middle = std::chrono::steady_clock::now ();
+      float rewards = 0;
+      for (uint32_t i = 0; i < nDecisions; i++)
+        {
+          rewards += control.Decide ();
+        }
+      auto end = std::chrono::steady_clock::now ();
+
+      result.packetNs = std::min (result.packetNs, std::chrono::duration<double, std::nano> (middle - start).count () / nPackets);
+      result.decisionNs = std::min (result.decisionNs, std::chrono::duration<double, std::nano> (end - middle).count () / nDecisions);
+      result.checksum += accepted + rewards + control.GetDecisionCount ();
+    }
+  return result;
+}
+
+template <class Schema>
+void
+Compare (const char* name, const std::vector<Packet>& packets, uint32_t nPackets, uint32_t nDecisions,
+         uint32_t repeat)
+{
+  bool flows = Schema::FLOWS;
+  bool ecn = Schema::ECN;
+  Result runtime = Measure<RuntimeControl> (packets, nPackets, nDecisions, repeat, flows, ecn);
+  Result specialized = Measure<SpecializedControl<Schema, NativeDecision> > (packets, nPackets, nDecisions, repeat,
+                                                                            flows, ecn);
+  std::cout << std::setw (10) << name
+            << std::setw (12) << runtime.packetNs << std::setw (12) << specialized.packetNs
+            << std::setw (9) << runtime.packetNs / specialized.packetNs << "x"
+            << std::setw (12) << runtime.decisionNs << std::setw (12) << specialized.decisionNs
+            << std::setw (9) << runtime.decisionNs / specialized.decisionNs << "x"
+            << "   (checksums " << runtime.checksum << " " << specialized.checksum << ")" << std::endl;
+}
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nPackets = 10000000;
+  uint32_t nDecisions = 1000000;
+  uint32_t repeat = 5;
+  uint32_t nFlows = 100;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("packets", "Enqueue/dequeue iterations per run", nPackets);
+  cmd.AddValue ("decisions", "Decisions per run", nDecisions);
+  cmd.AddValue ("repeat", "Runs per configuration, the best one is reported", repeat);
+  cmd.AddValue ("flows", "Number of flows of the packet sequence", nFlows);
+  cmd.Parse (argc, argv);
+
+  std::mt19937 rng (1);
+  std::uniform_int_distribution<uint32_t> size (64, 1500);
+  std::uniform_int_distribution<uint32_t> flow (1, nFlows);
+  std::vector<Packet> packets (1 << 16);
+  for (Packet& p : packets)
+    {
+      p.size = size (rng);
+      p.hash = flow (rng) * 2654435761u;
+    }
+
+  std::ios_base::fmtflags flags = std::cout.flags ();
+  std::streamsize precision = std::cout.precision ();
+  std::cout << std::fixed << std::setprecision (1)
+            << "    schema  packet ns/op (runtime, specialized)   decision ns/op (runtime, specialized)" << std::endl;
+  Compare<BaseSchema> ("Base", packets, nPackets, nDecisions, repeat);
+  Compare<FlowSchema> ("Flows", packets, nPackets, nDecisions, repeat);
+  Compare<EcnSchema> ("Ecn", packets, nPackets, nDecisions, repeat);
+  Compare<FlowEcnSchema> ("FlowsEcn", packets, nPackets, nDecisions, repeat);
+  std::cout.flags (flags);
+  std::cout.precision (precision);
+  return 0;
+}
@@ -0,0 +1,80 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+// Single dumbbell benchmark
+//
+//  s0 ---+                           +--- r0
+//  s1 ---+-- R0 ==== bottleneck ==== R1 --+--- r1
+//  ...   |                           |    ...
+//  sN ---+                           +--- rN
+//
+// Flow i is a bulk TCP transfer from si to ri. DuelingDQNFifoQueueDisc is
+// installed on the R0 -> R1 bottleneck device.
+
+#include "bench-common.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("DumbbellBench");
+
+int
+main (int argc, char *argv[])
+{
+  BenchOptions opts;
+  uint32_t nFlows = 10;
+  std::string accessRate = "1Gbps";
+  std::string accessDelay = "1ms";
+  std::string bottleneckRate = "100Mbps";
+  std::string bottleneckDelay = "10ms";
+
+  CommandLine cmd (__FILE__);
+  opts.AddValues (cmd);
+  cmd.AddValue ("nFlows", "Number of sender/receiver pairs", nFlows);
+  cmd.AddValue ("accessRate", "Rate of the access links", accessRate);
+  cmd.AddValue ("accessDelay", "Delay of the access links", accessDelay);
+  cmd.AddValue ("bottleneckRate", "Rate of the bottleneck link", bottleneckRate);
+  cmd.AddValue ("bottleneckDelay", "Delay of the bottleneck link", bottleneckDelay);
+  cmd.Parse (argc, argv);
+  opts.Apply ();
+
+  NodeContainer routers;
+  routers.Create (2);
+  NodeContainer senders;
+  senders.Create (nFlows);
+  NodeContainer receivers;
+  receivers.Create (nFlows);
+
+  InternetStackHelper stack;
+  stack.InstallAll ();
+
+  PointToPointHelper access = MakeLink (accessRate, accessDelay);
+  PointToPointHelper bottleneck = MakeLink (bottleneckRate, bottleneckDelay);
+  Ipv4AddressHelper address ("10.0.0.0", "255.255.255.0");
+
+  NetDeviceContainer bottleneckDevices = bottleneck.Install (routers.Get (0), routers.Get (1));
+  TrafficControlHelper tch = opts.GetBottleneckHelper ();
+  ScenarioBenchmark bench ("dumbbell");
+  bench.AddQueueDiscs (tch.Install (bottleneckDevices.Get (0)));
+  address.Assign (bottleneckDevices);
+
+  std::vector<Ipv4Address> receiverAddresses;
+  for (uint32_t i = 0; i < nFlows; i++)
+    {
+      address.NewNetwork ();
+      address.Assign (access.Install (senders.Get (i), routers.Get (0)));
+      address.NewNetwork ();
+      Ipv4InterfaceContainer ifaces = address.Assign (access.Install (receivers.Get (i), routers.Get (1)));
+      receiverAddresses.push_back (ifaces.GetAddress (0));
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  Ptr<UniformRandomVariable> startJitter = CreateObject<UniformRandomVariable> ();
+  startJitter->SetAttribute ("Max", DoubleValue (1.0));
+  for (uint32_t i = 0; i < nFlows; i++)
+    {
+      InstallBulkFlow (senders.Get (i), receivers.Get (i), receiverAddresses[i], 5000,
+                       Seconds (startJitter->GetValue ()), Seconds (opts.simTime));
+    }
+
+  bench.Run (Seconds (opts.simTime));
+  return 0;
+}
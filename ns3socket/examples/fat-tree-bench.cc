@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+// Large k-ary fat-tree benchmark
+//
+// k pods of k/2 edge and k/2 aggregation switches, (k/2)^2 core switches
+// and k^3/4 hosts. Every edge switch connects to all aggregation switches
+// of its pod, aggregation switch j of each pod connects to core switches
+// j*k/2 ... (j+1)*k/2-1. Routing uses ECMP over global routes.
+//
+// Hosts send bulk TCP flows following a seeded random permutation.
+// DuelingDQNFifoQueueDisc is installed on both ends of every switch to
+// switch link, i.e. on all the ports where flows contend.
+
+#include "bench-common.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("FatTreeBench");
+
+int
+main (int argc, char *argv[])
+{
+  BenchOptions opts;
+  uint32_t k = 8;
+  uint32_t flowsPerHost = 1;
+  std::string linkRate = "1Gbps";
+  std::string linkDelay = "20us";
+
+  CommandLine cmd (__FILE__);
+  opts.AddValues (cmd);
+  cmd.AddValue ("k", "Fat-tree arity, must be even", k);
+  cmd.AddValue ("flowsPerHost", "Number of flows started by each host", flowsPerHost);
+  cmd.AddValue ("linkRate", "Rate of all links", linkRate);
+  cmd.AddValue ("linkDelay", "Delay of all links", linkDelay);
+  cmd.Parse (argc, argv);
+  NS_ABORT_MSG_IF (k < 2 || k % 2 != 0, "The fat-tree arity must be even");
+  opts.Apply ();
+  Config::SetDefault ("ns3::Ipv4GlobalRouting::RandomEcmpRouting", BooleanValue (true));
+
+  uint32_t half = k / 2;
+  uint32_t nHosts = k * half * half;
+
+  NodeContainer core;
+  core.Create (half * half);
+  NodeContainer aggr;
+  aggr.Create (k * half);
+  NodeContainer edge;
+  edge.Create (k * half);
+  NodeContainer hosts;
+  hosts.Create (nHosts);
+
+  InternetStackHelper stack;
+  stack.InstallAll ();
+
+  PointToPointHelper link = MakeLink (linkRate, linkDelay);
+  Ipv4AddressHelper address ("10.0.0.0", "255.255.255.0");
+  TrafficControlHelper tch = opts.GetBottleneckHelper ();
+  ScenarioBenchmark bench ("fat-tree");
+
+  std::vector<Ipv4Address> hostAddresses;
+  for (uint32_t pod = 0; pod < k; pod++)
+    {
+      for (uint32_t e = 0; e < half; e++)
+        {
+          Ptr<Node> edgeSwitch = edge.Get (pod * half + e);
+          for (uint32_t h = 0; h < half; h++)
+            {
+              Ptr<Node> host = hosts.Get ((pod * half + e) * half + h);
+              Ipv4InterfaceContainer ifaces = address.Assign (link.Install (host, edgeSwitch));
+              address.NewNetwork ();
+              hostAddresses.push_back (ifaces.GetAddress (0));
+            }
+          for (uint32_t a = 0; a < half; a++)
+            {
+              NetDeviceContainer devices = link.Install (edgeSwitch, aggr.Get (pod * half + a));
+              bench.AddQueueDiscs (tch.Install (devices));
+              address.Assign (devices);
+              address.NewNetwork ();
+            }
+        }
+      for (uint32_t a = 0; a < half; a++)
+        {
+          for (uint32_t c = 0; c < half; c++)
+            {
+              NetDeviceContainer devices = link.Install (aggr.Get (pod * half + a), core.Get (a * half + c));
+              bench.AddQueueDiscs (tch.Install (devices));
+              address.Assign (devices);
+              address.NewNetwork ();
+            }
+        }
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  // Random permutation traffic, drawn from the seeded ns-3 RNG
+  Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable> ();
+  Ptr<UniformRandomVariable> startJitter = CreateObject<UniformRandomVariable> ();
+  startJitter->SetAttribute ("Max", DoubleValue (1.0));
+  for (uint32_t f = 0; f < flowsPerHost; f++)
+    {
+      std::vector<uint32_t> perm (nHosts);
+      for (uint32_t i = 0; i < nHosts; i++)
+        {
+          perm[i] = i;
+        }
+      for (uint32_t i = nHosts - 1; i > 0; i--)
+        {
+          std::swap (perm[i], perm[uniform->GetInteger (0, i)]);
+        }
+      for (uint32_t i = 0; i < nHosts; i++)
+        {
+          // Fixed points would stay inside the host, send to the neighbour instead
+          uint32_t dst = perm[i] != i ? perm[i] : (i + 1) % nHosts;
+          InstallBulkFlow (hosts.Get (i), hosts.Get (dst), hostAddresses[dst], 5000 + f * nHosts + i,
+                           Seconds (startJitter->GetValue ()), Seconds (opts.simTime));
+        }
+    }
+
+  bench.Run (Seconds (opts.simTime));
+  return 0;
+}
@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+// Many-flow incast benchmark
+//
+//   s0 ---+
+//   s1 ---+
+//   ...   +-- switch ==== receiver
+//   sN ---+
+//
+// Every round all N senders answer a synchronized request with a response
+// of responseSize bytes, so the switch -> receiver port sees periodic
+// bursts of N concurrent flows. DuelingDQNFifoQueueDisc is installed on
+// that port.
+
+#include "bench-common.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("IncastBench");
+
+int
+main (int argc, char *argv[])
+{
+  BenchOptions opts;
+  uint32_t nSenders = 64;
+  uint32_t responseSize = 64 * 1024;
+  double roundInterval = 0.1;
+  std::string linkRate = "10Gbps";
+  std::string linkDelay = "10us";
+
+  CommandLine cmd (__FILE__);
+  opts.AddValues (cmd);
+  cmd.AddValue ("nSenders", "Number of senders answering each request", nSenders);
+  cmd.AddValue ("responseSize", "Bytes sent by each sender per round", responseSize);
+  cmd.AddValue ("roundInterval", "Seconds between two requests", roundInterval);
+  cmd.AddValue ("linkRate", "Rate of all links", linkRate);
+  cmd.AddValue ("linkDelay", "Delay of all links", linkDelay);
+  cmd.Parse (argc, argv);
+  opts.Apply ();
+
+  NodeContainer tor;
+  tor.Create (1);
+  NodeContainer receiver;
+  receiver.Create (1);
+  NodeContainer senders;
+  senders.Create (nSenders);
+
+  InternetStackHelper stack;
+  stack.InstallAll ();
+
+  PointToPointHelper link = MakeLink (linkRate, linkDelay);
+  Ipv4AddressHelper address ("10.0.0.0", "255.255.255.0");
+
+  NetDeviceContainer bottleneckDevices = link.Install (tor.Get (0), receiver.Get (0));
+  TrafficControlHelper tch = opts.GetBottleneckHelper ();
+  ScenarioBenchmark bench ("incast");
+  bench.AddQueueDiscs (tch.Install (bottleneckDevices.Get (0)));
+  Ipv4InterfaceContainer receiverIfaces = address.Assign (bottleneckDevices);
+  Ipv4Address receiverAddress = receiverIfaces.GetAddress (1);
+
+  for (uint32_t i = 0; i < nSenders; i++)
+    {
+      address.NewNetwork ();
+      address.Assign (link.Install (senders.Get (i), tor.Get (0)));
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  uint16_t port = 5000;
+  PacketSinkHelper sink ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+  ApplicationContainer sinkApp = sink.Install (receiver.Get (0));
+  sinkApp.Start (Seconds (0));
+  sinkApp.Stop (Seconds (opts.simTime));
+
+  // Responses leave within a few microseconds of each other, as after a
+  // real request fan-out
+  Ptr<UniformRandomVariable> jitter = CreateObject<UniformRandomVariable> ();
+  jitter->SetAttribute ("Max", DoubleValue (20e-6));
+  BulkSendHelper response ("ns3::TcpSocketFactory", InetSocketAddress (receiverAddress, port));
+  response.SetAttribute ("MaxBytes", UintegerValue (responseSize));
+  for (double t = roundInterval; t < opts.simTime; t += roundInterval)
+    {
+      for (uint32_t i = 0; i < nSenders; i++)
+        {
+          ApplicationContainer app = response.Install (senders.Get (i));
+          app.Start (Seconds (t + jitter->GetValue ()));
+          app.Stop (Seconds (opts.simTime));
+        }
+    }
+
+  bench.Run (Seconds (opts.simTime));
+  return 0;
+}
@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+// Parking lot benchmark
+//
+//   long senders                                      long receivers
+//        \                                                /
+//         R0 ====== R1 ====== R2 ====== ... ====== Rh ---
+//         |  \      |  \      |                    |
+//       cross0 ->  cross0   cross1 ->            cross(h-1)
+//
+// Long flows cross all h bottleneck hops, every hop i additionally carries
+// cross flows entering at Ri and leaving at R(i+1). DuelingDQNFifoQueueDisc
+// is installed on every Ri -> R(i+1) device.
+
+#include "bench-common.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("ParkingLotBench");
+
+int
+main (int argc, char *argv[])
+{
+  BenchOptions opts;
+  uint32_t nHops = 3;
+  uint32_t nLong = 4;
+  uint32_t nCross = 4;
+  std::string accessRate = "1Gbps";
+  std::string accessDelay = "1ms";
+  std::string bottleneckRate = "100Mbps";
+  std::string bottleneckDelay = "5ms";
+
+  CommandLine cmd (__FILE__);
+  opts.AddValues (cmd);
+  cmd.AddValue ("nHops", "Number of bottleneck hops", nHops);
+  cmd.AddValue ("nLong", "Number of flows crossing all hops", nLong);
+  cmd.AddValue ("nCross", "Number of cross flows per hop", nCross);
+  cmd.AddValue ("accessRate", "Rate of the access links", accessRate);
+  cmd.AddValue ("accessDelay", "Delay of the access links", accessDelay);
+  cmd.AddValue ("bottleneckRate", "Rate of the router links", bottleneckRate);
+  cmd.AddValue ("bottleneckDelay", "Delay of the router links", bottleneckDelay);
+  cmd.Parse (argc, argv);
+  opts.Apply ();
+
+  NodeContainer routers;
+  routers.Create (nHops + 1);
+  NodeContainer longSenders;
+  longSenders.Create (nLong);
+  NodeContainer longReceivers;
+  longReceivers.Create (nLong);
+  NodeContainer crossSenders;
+  crossSenders.Create (nHops * nCross);
+  NodeContainer crossReceivers;
+  crossReceivers.Create (nHops * nCross);
+
+  InternetStackHelper stack;
+  stack.InstallAll ();
+
+  PointToPointHelper access = MakeLink (accessRate, accessDelay);
+  PointToPointHelper bottleneck = MakeLink (bottleneckRate, bottleneckDelay);
+  Ipv4AddressHelper address ("10.0.0.0", "255.255.255.0");
+  TrafficControlHelper tch = opts.GetBottleneckHelper ();
+  ScenarioBenchmark bench ("parking-lot");
+
+  for (uint32_t h = 0; h < nHops; h++)
+    {
+      NetDeviceContainer devices = bottleneck.Install (routers.Get (h), routers.Get (h + 1));
+      bench.AddQueueDiscs (tch.Install (devices.Get (0)));
+      address.Assign (devices);
+      address.NewNetwork ();
+    }
+
+  std::vector<Ipv4Address> longAddresses;
+  for (uint32_t i = 0; i < nLong; i++)
+    {
+      address.Assign (access.Install (longSenders.Get (i), routers.Get (0)));
+      address.NewNetwork ();
+      Ipv4InterfaceContainer ifaces = address.Assign (access.Install (longReceivers.Get (i), routers.Get (nHops)));
+      address.NewNetwork ();
+      longAddresses.push_back (ifaces.GetAddress (0));
+    }
+
+  std::vector<Ipv4Address> crossAddresses;
+  for (uint32_t h = 0; h < nHops; h++)
+    {
+      for (uint32_t i = 0; i < nCross; i++)
+        {
+          uint32_t n = h * nCross + i;
+          address.Assign (access.Install (crossSenders.Get (n), routers.Get (h)));
+          address.NewNetwork ();
+          Ipv4InterfaceContainer ifaces = address.Assign (access.Install (crossReceivers.Get (n), routers.Get (h + 1)));
+          address.NewNetwork ();
+          crossAddresses.push_back (ifaces.GetAddress (0));
+        }
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  Ptr<UniformRandomVariable> startJitter = CreateObject<UniformRandomVariable> ();
+  startJitter->SetAttribute ("Max", DoubleValue (1.0));
+  for (uint32_t i = 0; i < nLong; i++)
+    {
+      InstallBulkFlow (longSenders.Get (i), longReceivers.Get (i), longAddresses[i], 5000,
+                       Seconds (startJitter->GetValue ()), Seconds (opts.simTime));
+    }
+  for (uint32_t n = 0; n < nHops * nCross; n++)
+    {
+      InstallBulkFlow (crossSenders.Get (n), crossReceivers.Get (n), crossAddresses[n], 5000,
+                       Seconds (startJitter->GetValue ()), Seconds (opts.simTime));
+    }
+
+  bench.Run (Seconds (opts.simTime));
+  return 0;
+}
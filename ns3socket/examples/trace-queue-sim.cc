@@ -0,0 +1,190 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+// Trace-driven training without the ns-3 network stack
+//
+// Replays a pcap or binary packet trace, or synthetic Poisson arrivals,
+// into a single bottleneck queue controlled like DuelingDQNFifoQueueDisc,
+// see TraceQueueSimulator. Every episode replays the trace from the start
+// on its own agent connection, so the Python server sees the same episode
+// protocol as with the full simulation, e.g.
+//
+//   ./waf --run "trace-queue-sim --trace=uplink.pcap --rate=20e6 --episodes=100"
+//
+// The arrivals do not react to the decisions, so the experience is meant
+// for pre-training before fine-tuning in the full simulation.
+
+#include "ns3/core-module.h"
+#include "ns3/ns3socket-module.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TraceQueueSim");
+
+int
+main (int argc, char *argv[])
+{
+  std::string trace;
+  double poissonRate = 2000;
+  uint32_t poissonSize = 1500;
+  uint32_t poissonFlows = 10;
+  double rate = 10e6;
+  std::string rateSchedule;
+  double duration = 0;
+  uint32_t episodes = 1;
+  uint32_t seed = 1;
+  uint32_t maxSize = 50;
+  double updatePeriod = 0.01;
+  double desiredQueueDelay = 2.0;
+  std::string policy = "Agent";
+  std::string fallbackPolicy = "Stub";
+  uint32_t fallbackAction = 1;
+  std::string agentAddress = "127.0.0.1";
+  uint16_t agentPort = 8888;
+  double decisionDeadline = 0;
+  double agentTimeout = 5;
+  std::string rateEstimator = "Ewma";
+  double rateHalfLife = 0.01;
+  uint32_t dequeueThreshold = 2000;
+  bool useEcn = false;
+  double markRatio = 0.5;
+  double signalPenalty = 0.5;
+  uint32_t flowTableSize = 0;
+  double flowAgeTimeout = 1;
+  bool instrumentation = false;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("trace", "pcap or binary packet trace, empty for Poisson arrivals", trace);
+  cmd.AddValue ("poissonRate", "Poisson arrival rate in packets/s", poissonRate);
+  cmd.AddValue ("poissonSize", "Poisson packet size in bytes", poissonSize);
+  cmd.AddValue ("poissonFlows", "Number of Poisson flows", poissonFlows);
+  cmd.AddValue ("rate", "Link rate in bits/s", rate);
+  cmd.AddValue ("rateSchedule", "File of \"time_s rate_bps\" link rate changes", rateSchedule);
+  cmd.AddValue ("duration", "Simulated seconds per episode, 0 for the whole trace (Poisson: 10 s)", duration);
+  cmd.AddValue ("episodes", "Number of episodes", episodes);
+  cmd.AddValue ("seed", "Seed of the Poisson arrivals, incremented per episode", seed);
+  cmd.AddValue ("maxSize", "Initial buffer size in packets", maxSize);
+  cmd.AddValue ("updatePeriod", "Slot time in s", updatePeriod);
+  cmd.AddValue ("desiredQueueDelay", "Desired queueing delay in s", desiredQueueDelay);
+  cmd.AddValue ("policy", "Decision policy: Agent, Stub or Native", policy);
+  cmd.AddValue ("fallbackPolicy", "Policy when the agent gives no action: Stub or Native", fallbackPolicy);
+  cmd.AddValue ("fallbackAction", "Action of the Stub fallback: 0 add, 1 keep, 2 reduce", fallbackAction);
+  cmd.AddValue ("agentAddress", "IPv4 address of the agent server", agentAddress);
+  cmd.AddValue ("agentPort", "Port of the agent server", agentPort);
+  cmd.AddValue ("decisionDeadline", "Wall-clock budget of an agent decision in s, 0 to wait forever", decisionDeadline);
+  cmd.AddValue ("agentTimeout", "Wall-clock time in s after which a silent agent is reconnected", agentTimeout);
+  cmd.AddValue ("rateEstimator", "Dequeue rate estimator: Ewma or Threshold", rateEstimator);
+  cmd.AddValue ("rateHalfLife", "Half-life of the Ewma estimator in s", rateHalfLife);
+  cmd.AddValue ("dequeueThreshold", "Backlog in bytes before the Threshold estimator measures", dequeueThreshold);
+  cmd.AddValue ("ecn", "Mark above MarkRatio of the buffer size, all packets count as ECT", useEcn);
+  cmd.AddValue ("markRatio", "ECN marking threshold as a fraction of the buffer size", markRatio);
+  cmd.AddValue ("signalPenalty", "Reward penalty per dropped or marked fraction of arrivals", signalPenalty);
+  cmd.AddValue ("flowTableSize", "Entries of the per-flow table, 0 to disable it", flowTableSize);
+  cmd.AddValue ("flowAgeTimeout", "Idle time in s after which a flow entry may be reused", flowAgeTimeout);
+  cmd.AddValue ("instrumentation", "Time the decisions and print a summary per episode", instrumentation);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (policy != "Agent" && policy != "Stub" && policy != "Native", "Unknown policy " << policy);
+  TraceQueueSimulator::Policy decisionPolicy = policy == "Agent" ? TraceQueueSimulator::AGENT
+                                               : policy == "Native" ? TraceQueueSimulator::NATIVE
+                                               : TraceQueueSimulator::STUB;
+  if (trace.empty () && duration <= 0)
+    {
+      duration = 10;
+    }
+
+  uint64_t totalArrivals = 0;
+  uint64_t totalDecisions = 0;
+  double totalSim = 0;
+  auto wallStart = std::chrono::steady_clock::now ();
+  for (uint32_t episode = 1; episode <= episodes; episode++)
+    {
+      std::unique_ptr<PacketTrace> arrivals;
+      if (trace.empty ())
+        {
+          arrivals.reset (new PoissonPacketTrace (poissonRate, poissonSize, poissonFlows, duration, seed + episode - 1));
+        }
+      else
+        {
+          arrivals = OpenPacketTrace (trace);
+          NS_ABORT_MSG_IF (!arrivals, "Unable to open the packet trace " << trace);
+        }
+
+      TraceQueueSimulator sim;
+      sim.SetServiceRate (rate);
+      NS_ABORT_MSG_IF (!rateSchedule.empty () && !sim.LoadRateSchedule (rateSchedule),
+                       "Unable to read the rate schedule " << rateSchedule);
+      sim.SetBufferSize (maxSize);
+      sim.SetUpdatePeriod (updatePeriod);
+      if (rateEstimator == "Threshold")
+        {
+          sim.SetRateEstimator (std::unique_ptr<RateEstimator> (new ThresholdRateEstimator (dequeueThreshold)), false);
+        }
+      else
+        {
+          sim.SetRateEstimator (std::unique_ptr<RateEstimator> (new EwmaRateEstimator (rateHalfLife)), true);
+        }
+      sim.SetFlowTable (flowTableSize, flowAgeTimeout);
+      sim.GetController ().SetDesiredQueueDelay (desiredQueueDelay);
+      sim.GetController ().SetEcn (useEcn, markRatio, signalPenalty);
+
+      DecisionStats stats;
+      sim.SetStats (instrumentation ? &stats : nullptr);
+      NS3Client* client = nullptr;
+      if (decisionPolicy == TraceQueueSimulator::AGENT)
+        {
+          client = new NS3Client (agentAddress.c_str (), agentPort);
+          client->SetStats (instrumentation ? &stats : nullptr);
+          client->SetDeadline (decisionDeadline > 0 ? (int64_t)(decisionDeadline * 1e9) : -1);
+          client->SetHangTimeout ((int64_t)(agentTimeout * 1e9));
+        }
+      sim.SetPolicy (decisionPolicy, client);
+      sim.SetFallback (fallbackPolicy == "Native" ? TraceQueueSimulator::NATIVE : TraceQueueSimulator::STUB,
+                       fallbackAction);
+
+      sim.Run (*arrivals, duration);
+
+      const BufferController& controller = sim.GetController ();
+      std::cout << "Episode " << episode << ": " << sim.GetArrivals () << " arrivals, "
+                << sim.GetDrops () << " drops, " << sim.GetMarks () << " marks in " << sim.GetTime () << " s" << std::endl
+                << "Sum of rewards: " << controller.GetRewardsSum () << ", step count: " << controller.GetSteps () << std::endl
+                << "Number of Add action: " << controller.GetActionCount (0) << ", Reduce action: " << controller.GetActionCount (2)
+                << ", Keep action: " << controller.GetActionCount (1) << std::endl
+                << "The average buffer size: " << sim.GetAverageBufferSize () << std::endl;
+      if (client)
+        {
+          std::cout << "Fallback decisions: " << sim.GetFallbacks () << ", Missed deadlines: " << client->GetMissedDeadlines ()
+                    << ", Reconnects: " << client->GetReconnects () << std::endl;
+          DRLstate done = {(float)0.0, (float)0.0, (float)0.0, (float)0.0, (float)0.0, true, {}};
+          client->SendData (&done);
+          client->CloseClient ();
+          delete client;
+        }
+      if (instrumentation)
+        {
+          stats.Summary (std::cout);
+        }
+      std::cout << std::endl;
+
+      totalArrivals += sim.GetArrivals ();
+      totalDecisions += controller.GetDecisionCount ();
+      totalSim += sim.GetTime ();
+    }
+  double wall = std::chrono::duration<double> (std::chrono::steady_clock::now () - wallStart).count ();
+
+  std::ios_base::fmtflags flags = std::cout.flags ();
+  std::streamsize precision = std::cout.precision ();
+  std::cout << std::fixed << std::setprecision (3)
+            << "=== trace-queue-sim ===" << std::endl
+            << "Simulated time: " << totalSim << " s" << std::endl
+            << "Wall-clock time: " << wall << " s" << std::endl
+            << "Simulated s per wall-clock s: " << totalSim / wall << std::endl
+            << "Packets: " << totalArrivals << " (" << totalArrivals / wall << " packets/s)" << std::endl
+            << "Decisions: " << totalDecisions << " (" << totalDecisions / wall << " decisions/s)" << std::endl;
+  std::cout.flags (flags);
+  std::cout.precision (precision);
+  return 0;
+}
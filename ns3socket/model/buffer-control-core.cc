@@ -0,0 +1,86 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "buffer-control-core.h"
+#include "ns3socket.h"
+
+namespace ns3
+{
+
+AgentDecision::AgentDecision ()
+  : m_client (nullptr),
+    m_fallbackNative (false),
+    m_fallbackAction (1),
+    m_fallbacks (0)
+{
+}
+
+AgentDecision::~AgentDecision ()
+{
+  delete m_client;
+}
+
+void
+AgentDecision::Connect (const std::string& address, uint16_t port, int64_t deadline, int64_t hangTimeout,
+                        DecisionStats* stats)
+{
+  delete m_client;
+  m_client = new NS3Client (address.c_str (), port);
+  m_client->SetStats (stats);
+  m_client->SetDeadline (deadline);
+  m_client->SetHangTimeout (hangTimeout);
+  m_fallbacks = 0;
+}
+
+void
+AgentDecision::SetFallback (bool native, action_t action)
+{
+  m_fallbackNative = native;
+  m_fallbackAction = action;
+}
+
+void
+AgentDecision::Finish (void)
+{
+  if (m_client)
+    {
+      DRLstate state = {(float)0.0, (float)0.0, (float)0.0, (float)0.0, (float)0.0, true, {}};
+      m_client->SendData (&state);
+      m_client->CloseClient ();
+      delete m_client;
+      m_client = nullptr;
+    }
+}
+
+bool
+AgentDecision::Exchange (const double* ob, uint32_t n, float reward, action_t& action)
+{
+  if (!m_client)
+    {
+      return false;
+    }
+  DRLstate state = {(float)ob[0], (float)ob[1], (float)ob[2], (float)ob[3], reward, false,
+                    std::vector<float> (ob + 4, ob + n)};  //Optional features
+  float reply = -1;
+  bool sent = m_client->SendData (&state);
+  bool received = m_client->RecvData (reply);  //Even if not sent, so that every stage is timed
+  if (sent && received && reply >= 0 && reply <= 2)
+    {
+      action = (action_t)reply;
+      return true;
+    }
+  return false;
+}
+
+uint64_t
+AgentDecision::GetFallbacks (void) const
+{
+  return m_fallbacks;
+}
+
+NS3Client*
+AgentDecision::GetClient (void) const
+{
+  return m_client;
+}
+
+}
@@ -0,0 +1,493 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef BUFFER_CONTROL_CORE_H
+#define BUFFER_CONTROL_CORE_H
+
+#include "buffer-controller.h"
+#include "decision-stats.h"
+#include "flow-table.h"
+#include "rate-estimator.h"
+
+#include <array>
+#include <string>
+
+namespace ns3
+{
+
+class NS3Client;
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Buffer sized in packets, one packet per add or reduce action.
+ */
+struct PacketSizing
+{
+  static const bool BYTES = false;
+  static const uint32_t STEP = 1;
+  static const uint32_t MIN_SIZE = 1;
+  static const uint32_t MAX_SIZE = 100;
+  static const uint32_t DEFAULT_SIZE = 50;
+  static const char* GetName (void) { return "Packets"; }
+  static uint32_t Occupancy (uint32_t packets, uint32_t) { return packets; }
+  static uint32_t Cost (uint32_t) { return 1; }
+};
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Buffer sized in bytes, one 1500 byte packet per add or reduce action.
+ */
+struct ByteSizing
+{
+  static const bool BYTES = true;
+  static const uint32_t STEP = 1500;
+  static const uint32_t MIN_SIZE = 1500;
+  static const uint32_t MAX_SIZE = 150000;
+  static const uint32_t DEFAULT_SIZE = 75000;
+  static const char* GetName (void) { return "Bytes"; }
+  static uint32_t Occupancy (uint32_t, uint32_t bytes) { return bytes; }
+  static uint32_t Cost (uint32_t size) { return size; }
+};
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Observation schemas: the 4 base features, followed by the active flows
+ * and Jain index with FLOWS and by the slot drops and marks with ECN. ECN
+ * also enables marking.
+ */
+struct BaseSchema
+{
+  static const bool FLOWS = false;
+  static const bool ECN = false;
+  static const uint32_t SIZE = 4;
+  static const char* GetName (void) { return "Base"; }
+};
+
+struct FlowSchema
+{
+  static const bool FLOWS = true;
+  static const bool ECN = false;
+  static const uint32_t SIZE = 6;
+  static const char* GetName (void) { return "Flows"; }
+};
+
+struct EcnSchema
+{
+  static const bool FLOWS = false;
+  static const bool ECN = true;
+  static const uint32_t SIZE = 6;
+  static const char* GetName (void) { return "Ecn"; }
+};
+
+struct FlowEcnSchema
+{
+  static const bool FLOWS = true;
+  static const bool ECN = true;
+  static const uint32_t SIZE = 8;
+  static const char* GetName (void) { return "FlowsEcn"; }
+};
+
+/**
+ * \ingroup NS3Socket
+ *
+ * BufferController specialized at compile time.
+ *
+ * The sizing unit, the observation schema and the rate estimator are
+ * template parameters, so the per-packet hooks carry no configuration
+ * branch, the estimator is called without virtual dispatch and the
+ * observation is a fixed-size array instead of a heap-allocated vector.
+ * The sizing, reward and heuristic formulas are the static ones of
+ * BufferController, so both controllers take the same decisions.
+ *
+ * Times are in ns.
+ */
+template <class Sizing, class Schema, class Estimator = EwmaRateEstimator>
+class BufferControlCore
+{
+public:
+  typedef std::array<double, Schema::SIZE> Observation;
+
+  /**
+   * \param estimator the dequeue rate estimator, copied
+   */
+  explicit BufferControlCore (const Estimator& estimator)
+    : m_estimator (estimator),
+      m_desiredQueueDelay (2.0),
+      m_markRatio (0.5),
+      m_signalPenalty (0.5)
+  {
+    Reset (Sizing::DEFAULT_SIZE);
+  }
+
+  void SetDesiredQueueDelay (double delay)
+  {
+    m_desiredQueueDelay = delay;
+  }
+  /**
+   * \param markRatio the marking threshold as a fraction of the buffer size
+   * \param signalPenalty reward penalty per dropped or marked fraction of the arrivals
+   */
+  void SetEcn (double markRatio, double signalPenalty)
+  {
+    m_markRatio = markRatio;
+    m_signalPenalty = signalPenalty;
+  }
+  /**
+   * \param capacity the flow table entries
+   * \param ageTimeout the idle time in ns after which an entry may be reused
+   */
+  void SetFlowTable (uint32_t capacity, uint64_t ageTimeout)
+  {
+    m_flows.SetCapacity (Schema::FLOWS ? capacity : 0);
+    m_flows.SetAgeTimeout (ageTimeout);
+  }
+
+  /**
+   * \brief Forget the slot and episode state
+   * \param size the buffer size in Sizing units
+   */
+  void Reset (uint32_t size)
+  {
+    m_size = size;
+    m_arrivals = 0;
+    m_drops = 0;
+    m_marks = 0;
+    m_congestion = 0;
+    m_currQueueDelay = 0;
+    m_oldQueueDelay = 0;
+    m_action = 1;
+    m_reward = 0;
+    m_markThreshold = BufferController::MarkThreshold (m_markRatio, m_size);
+    ResetEpisode ();
+  }
+  void ResetEpisode (void)
+  {
+    m_rewardsSum = 0;
+    m_steps = 0;
+    m_actionCount[0] = m_actionCount[1] = m_actionCount[2] = 0;
+  }
+
+  /**
+   * \param packets the backlog in packets
+   * \param bytes the backlog in bytes
+   * \param size the size of the arriving packet
+   * \param hash the flow hash, only used with FLOWS
+   * \param now the time, only used with FLOWS
+   * \return false if the packet does not fit in the buffer and is dropped
+   */
+  bool Admit (uint32_t packets, uint32_t bytes, uint32_t size, uint32_t hash, uint64_t now)
+  {
+    if (Sizing::Occupancy (packets, bytes) + Sizing::Cost (size) <= m_size)
+      {
+        return true;
+      }
+    NotifyEnqueue (false, hash, now);
+    return false;
+  }
+  /**
+   * \return true if an admitted ECT packet must be marked
+   */
+  bool ShouldMark (uint32_t packets, uint32_t bytes) const
+  {
+    return Schema::ECN && Sizing::Occupancy (packets, bytes) >= m_markThreshold;
+  }
+  void NotifyMark (void)
+  {
+    m_marks++;
+  }
+  /**
+   * \brief Account an arrival, Admit already does it for the drops at the size limit
+   * \param accepted true if the queue took it
+   */
+  void NotifyEnqueue (bool accepted, uint32_t hash, uint64_t now)
+  {
+    if (accepted)
+      {
+        m_arrivals++;
+        if (m_congestion < 5)
+          {
+            m_congestion++;
+          }
+        if (Schema::FLOWS)
+          {
+            m_flows.NotifyEnqueue (hash, now);
+          }
+      }
+    else
+      {
+        m_drops++;
+        if (m_congestion > -5)
+          {
+            m_congestion--;
+          }
+        if (Schema::FLOWS)
+          {
+            m_flows.NotifyDrop (hash, now);
+          }
+      }
+  }
+  /**
+   * \param size the size of the departing packet
+   * \param bytes the backlog in bytes after the departure
+   */
+  void NotifyDequeue (uint32_t size, uint32_t hash, uint64_t now, uint32_t bytes)
+  {
+    if (Schema::FLOWS)
+      {
+        m_flows.NotifyDequeue (hash, size, now);
+      }
+    m_estimator.Update (now * 1e-9, size, bytes);
+  }
+
+  /**
+   * \brief Build the state of the slot that just ended
+   */
+  void Observe (uint32_t packets, uint32_t bytes, Observation& ob)
+  {
+    double rate = m_estimator.GetRate ();
+    m_currQueueDelay = rate > 0 ? bytes / rate : 0.0;
+    ob[0] = Sizing::Occupancy (packets, bytes);
+    ob[1] = rate * 8 / 1e+6;  // Convert to Mbps
+    ob[2] = m_currQueueDelay;
+    ob[3] = m_size;
+    uint32_t i = 4;
+    if (Schema::FLOWS)
+      {
+        ob[i++] = m_flows.GetActiveFlows ();
+        ob[i++] = m_flows.GetJainIndex ();
+      }
+    if (Schema::ECN)
+      {
+        ob[i++] = m_drops;
+        ob[i++] = m_marks;
+      }
+  }
+  action_t NativeAction (const Observation& ob) const
+  {
+    return BufferController::Native (ob[2], m_desiredQueueDelay, m_drops);
+  }
+  /**
+   * \brief Apply an action and close the slot
+   * \return the new buffer size
+   */
+  uint32_t ApplyAction (action_t action, uint32_t packets, uint32_t bytes)
+  {
+    m_size = BufferController::Resize (action, m_size, Sizing::Occupancy (packets, bytes),
+                                       Sizing::STEP, Sizing::MIN_SIZE, Sizing::MAX_SIZE);
+    if (action <= 2)
+      {
+        m_actionCount[action]++;
+      }
+    m_action = action;
+    m_markThreshold = BufferController::MarkThreshold (m_markRatio, m_size);
+    m_arrivals = 0;
+    m_drops = 0;
+    m_marks = 0;
+    m_oldQueueDelay = m_currQueueDelay;
+    if (Schema::FLOWS)
+      {
+        m_flows.NewSlot ();
+      }
+    return m_size;
+  }
+  /**
+   * \brief Close a slot without a decision, only the flow table starts a new one
+   */
+  void IdleSlot (void)
+  {
+    if (Schema::FLOWS)
+      {
+        m_flows.NewSlot ();
+      }
+  }
+  /**
+   * \brief Compute the reward of the last action, one slot after it
+   */
+  float CalculateReward (uint32_t packets, uint32_t bytes)
+  {
+    double rate = m_estimator.GetRate ();
+    m_currQueueDelay = rate > 0 ? bytes / rate : 0.0;
+    m_reward = BufferController::Reward (m_currQueueDelay, m_desiredQueueDelay, m_congestion > 0,
+                                         (float)Sizing::Occupancy (packets, bytes) / m_size,
+                                         Schema::ECN ? m_signalPenalty : 0, m_arrivals + m_drops, m_drops + m_marks);
+    m_rewardsSum += m_reward;
+    m_steps++;
+    if (BufferController::ShouldRestartRate (m_currQueueDelay, m_oldQueueDelay, m_desiredQueueDelay, m_action, rate))
+      {
+        m_estimator.Restart ();
+      }
+    m_action = 1;
+    return m_reward;
+  }
+
+  Estimator& GetEstimator (void) { return m_estimator; }
+  const FlowTable& GetFlowTable (void) const { return m_flows; }
+  uint32_t GetSize (void) const { return m_size; }
+  double GetQueueDelay (void) const { return m_currQueueDelay; }
+  float GetLastReward (void) const { return m_reward; }
+  float GetRewardsSum (void) const { return m_rewardsSum; }
+  uint32_t GetSteps (void) const { return m_steps; }
+  uint32_t GetActionCount (action_t action) const { return action <= 2 ? m_actionCount[action] : 0; }
+  uint32_t GetDecisionCount (void) const { return m_actionCount[0] + m_actionCount[1] + m_actionCount[2]; }
+
+private:
+  Estimator m_estimator;  // Held by value, so its calls are not virtual
+  FlowTable m_flows;
+  double m_desiredQueueDelay;
+  double m_markRatio;
+  double m_signalPenalty;
+  uint32_t m_size;            // Buffer size in Sizing units
+  uint32_t m_markThreshold;
+  uint32_t m_arrivals;        // Accepted arrivals in the slot
+  uint32_t m_drops;           // Dropped arrivals in the slot
+  uint32_t m_marks;           // ECN marks in the slot
+  int32_t m_congestion;       // Accepted minus rejected arrivals, within [-5, 5]
+  double m_currQueueDelay;
+  double m_oldQueueDelay;
+  action_t m_action;
+  float m_reward;
+  float m_rewardsSum;
+  uint32_t m_steps;
+  uint32_t m_actionCount[3];
+};
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Decision policies of a BufferControlCore.
+ */
+struct StubDecision
+{
+  static const char* GetName (void) { return "Stub"; }
+  template <class Core>
+  action_t Decide (Core&, const typename Core::Observation&)
+  {
+    return 1;
+  }
+};
+
+struct NativeDecision
+{
+  static const char* GetName (void) { return "Native"; }
+  template <class Core>
+  action_t Decide (Core& core, const typename Core::Observation& ob)
+  {
+    return core.NativeAction (ob);
+  }
+};
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Decisions of the remote agent over NS3Client, with a stub or native
+ * fallback when the agent gives no valid action.
+ */
+class AgentDecision
+{
+public:
+  AgentDecision ();
+  ~AgentDecision ();
+  AgentDecision (const AgentDecision&) = delete;
+  AgentDecision& operator= (const AgentDecision&) = delete;
+
+  static const char* GetName (void) { return "Agent"; }
+
+  /**
+   * \param address the agent address
+   * \param port the agent port
+   * \param deadline the decision deadline in ns, negative to wait forever
+   * \param hangTimeout the reconnect timeout in ns
+   * \param stats the decision stage counters, nullptr for none
+   */
+  void Connect (const std::string& address, uint16_t port, int64_t deadline, int64_t hangTimeout,
+                DecisionStats* stats);
+  /**
+   * \param native true to fall back to the heuristic, false for the fixed action
+   * \param action the fixed fallback action
+   */
+  void SetFallback (bool native, action_t action);
+  /**
+   * \brief Send the done state and close the connection
+   */
+  void Finish (void);
+
+  template <class Core>
+  action_t Decide (Core& core, const typename Core::Observation& ob)
+  {
+    action_t action;
+    if (Exchange (ob.data (), ob.size (), core.GetLastReward (), action))
+      {
+        return action;
+      }
+    m_fallbacks++;
+    return m_fallbackNative ? core.NativeAction (ob) : m_fallbackAction;
+  }
+
+  uint64_t GetFallbacks (void) const;
+  NS3Client* GetClient (void) const;
+
+private:
+  bool Exchange (const double* ob, uint32_t n, float reward, action_t& action);
+
+  NS3Client* m_client;
+  bool m_fallbackNative;
+  action_t m_fallbackAction;
+  uint64_t m_fallbacks;
+};
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Instrumentation levels: none, or the DecisionStats stages of every decision.
+ */
+struct NoInstrumentation
+{
+  static const bool ENABLED = false;
+  static const char* GetName (void) { return "Untimed"; }
+  DecisionStats* GetStats (void) { return nullptr; }
+  uint64_t Start (void) { return 0; }
+  void End (uint64_t) {}
+};
+
+class DecisionInstrumentation
+{
+public:
+  static const bool ENABLED = true;
+  static const char* GetName (void) { return "Timed"; }
+
+  DecisionInstrumentation ()
+    : m_lastEnd (0)
+  {
+  }
+  DecisionStats* GetStats (void)
+  {
+    return &m_stats;
+  }
+  /**
+   * \return the start of the decision, after recording the simulation since the previous one
+   */
+  uint64_t Start (void)
+  {
+    uint64_t start = DecisionStats::Now ();
+    m_stats.ClearLast ();
+    if (m_lastEnd > 0)
+      {
+        m_stats.Record (STAGE_SIMULATE, m_lastEnd, start);
+      }
+    return start;
+  }
+  void End (uint64_t start)
+  {
+    m_lastEnd = DecisionStats::Now ();
+    m_stats.Record (STAGE_DECISION, start, m_lastEnd);
+  }
+
+private:
+  DecisionStats m_stats;
+  uint64_t m_lastEnd;
+};
+
+}
+
+#endif /* BUFFER_CONTROL_CORE_H */
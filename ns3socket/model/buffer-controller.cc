@@ -0,0 +1,235 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "buffer-controller.h"
+#include "flow-table.h"
+#include "rate-estimator.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+BufferController::BufferController ()
+  : m_desiredQueueDelay (2.0),
+    m_useEcn (false),
+    m_markRatio (0.5),
+    m_signalPenalty (0.5),
+    m_minSize (1),
+    m_maxSize (100)
+{
+  Reset (0);
+}
+
+void
+BufferController::SetDesiredQueueDelay (double delay)
+{
+  m_desiredQueueDelay = delay;
+}
+
+void
+BufferController::SetEcn (bool useEcn, double markRatio, double signalPenalty)
+{
+  m_useEcn = useEcn;
+  m_markRatio = markRatio;
+  m_signalPenalty = signalPenalty;
+}
+
+void
+BufferController::SetSizeLimits (uint32_t minSize, uint32_t maxSize)
+{
+  m_minSize = minSize;
+  m_maxSize = maxSize;
+}
+
+void
+BufferController::Reset (uint32_t bufferSize)
+{
+  m_enqueuedPacket = 0;
+  m_droppedPacket = 0;
+  m_markedPacket = 0;
+  m_congestion = 0;
+  m_currQueueDelay = 0;
+  m_oldQueueDelay = 0;
+  m_action = 1;
+  m_singleReward = 0;
+  UpdateMarkThreshold (bufferSize);
+  ResetEpisode ();
+}
+
+void
+BufferController::ResetEpisode (void)
+{
+  m_rewardsSum = 0;
+  m_steps = 0;
+  std::fill (m_actionCount, m_actionCount + 3, 0);
+}
+
+void
+BufferController::NotifyArrival (bool accepted)
+{
+  if (accepted)
+    {
+      m_enqueuedPacket++;
+      if (m_congestion < 5)  //Record the current congestion situation
+        {
+          m_congestion++;
+        }
+    }
+  else
+    {
+      m_droppedPacket++;
+      if (m_congestion > -5)
+        {
+          m_congestion--;
+        }
+    }
+}
+
+void
+BufferController::NotifyMark (void)
+{
+  m_markedPacket++;
+}
+
+double
+BufferController::QueueDelay (uint32_t bytes, double rate) const
+{
+  return rate > 0 ? bytes / rate : 0.0;
+}
+
+observation_t
+BufferController::GetObservation (uint32_t packets, uint32_t bytes, uint32_t bufferSize,
+                                  double rate, const FlowTable* flows)
+{
+  m_currQueueDelay = QueueDelay (bytes, rate);
+
+  observation_t ob;
+  ob.push_back (packets);
+  ob.push_back (rate * 8 / 1e+6);  // Convert to Mbps
+  ob.push_back (m_currQueueDelay);
+  ob.push_back (bufferSize);
+  if (flows)  //Per-flow features of the slot that just ended
+    {
+      ob.push_back (flows->GetActiveFlows ());
+      ob.push_back (flows->GetJainIndex ());
+    }
+  if (m_useEcn)  //Congestion signals of the slot that just ended
+    {
+      ob.push_back (m_droppedPacket);
+      ob.push_back (m_markedPacket);
+    }
+  return ob;
+}
+
+action_t
+BufferController::NativeAction (const observation_t& ob) const
+{
+  return Native (ob[2], m_desiredQueueDelay, m_droppedPacket);
+}
+
+uint32_t
+BufferController::ApplyAction (action_t action, uint32_t bufferSize, uint32_t backlog)
+{
+  uint32_t newSize = Resize (action, bufferSize, backlog, 1, m_minSize, m_maxSize);
+  if (action <= 2)
+    {
+      m_actionCount[action]++;
+    }
+
+  m_action = action;
+  UpdateMarkThreshold (newSize);
+  m_enqueuedPacket = 0;
+  m_droppedPacket = 0;
+  m_markedPacket = 0;
+  m_oldQueueDelay = m_currQueueDelay;
+  return newSize;
+}
+
+float
+BufferController::CalculateReward (uint32_t packets, uint32_t bytes, uint32_t bufferSize,
+                                   RateEstimator& estimator)
+{
+  double rate = estimator.GetRate ();
+  m_currQueueDelay = QueueDelay (bytes, rate);
+
+  m_singleReward = Reward (m_currQueueDelay, m_desiredQueueDelay, m_congestion > 0, (float)packets / bufferSize,
+                          m_useEcn ? m_signalPenalty : 0, m_enqueuedPacket + m_droppedPacket,
+                          m_droppedPacket + m_markedPacket);
+  m_rewardsSum += m_singleReward;
+  m_steps++;
+
+  if (ShouldRestartRate (m_currQueueDelay, m_oldQueueDelay, m_desiredQueueDelay, m_action, rate))
+    {
+      estimator.Restart ();
+    }
+  m_action = 1;
+  return m_singleReward;
+}
+
+void
+BufferController::UpdateMarkThreshold (uint32_t bufferSize)
+{
+  m_markThreshold = MarkThreshold (m_markRatio, bufferSize);
+}
+
+uint32_t
+BufferController::GetMarkThreshold (void) const
+{
+  return m_markThreshold;
+}
+
+double
+BufferController::GetQueueDelay (void) const
+{
+  return m_currQueueDelay;
+}
+
+uint32_t
+BufferController::GetSlotArrivals (void) const
+{
+  return m_enqueuedPacket;
+}
+
+uint32_t
+BufferController::GetSlotDrops (void) const
+{
+  return m_droppedPacket;
+}
+
+uint32_t
+BufferController::GetSlotMarks (void) const
+{
+  return m_markedPacket;
+}
+
+float
+BufferController::GetLastReward (void) const
+{
+  return m_singleReward;
+}
+
+float
+BufferController::GetRewardsSum (void) const
+{
+  return m_rewardsSum;
+}
+
+uint32_t
+BufferController::GetSteps (void) const
+{
+  return m_steps;
+}
+
+uint32_t
+BufferController::GetActionCount (action_t action) const
+{
+  return action <= 2 ? m_actionCount[action] : 0;
+}
+
+uint32_t
+BufferController::GetDecisionCount (void) const
+{
+  return m_actionCount[0] + m_actionCount[1] + m_actionCount[2];
+}
+
+}
@@ -0,0 +1,240 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef BUFFER_CONTROLLER_H
+#define BUFFER_CONTROLLER_H
+
+#include <cstdint>
+#include <vector>
+
+using action_t = uint32_t;
+using observation_t = std::vector<double>;
+
+namespace ns3
+{
+
+class FlowTable;
+class RateEstimator;
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Buffer sizing control logic of DuelingDQNFifoQueueDisc: slot counters,
+ * observation, reward, the embedded heuristic and the add/keep/reduce
+ * actions on a buffer size in packets.
+ *
+ * It only sees queue sizes, rates in bytes/s and times in seconds, so the
+ * same logic drives the ns-3 queue disc and the standalone
+ * TraceQueueSimulator.
+ */
+class BufferController
+{
+public:
+  BufferController ();
+
+  /**
+   * \param delay the queueing delay the reward and the heuristic aim at, in s
+   */
+  void SetDesiredQueueDelay (double delay);
+  /**
+   * \param useEcn true to mark above the marking threshold and observe drops and marks
+   * \param markRatio the marking threshold as a fraction of the buffer size
+   * \param signalPenalty reward penalty per dropped or marked fraction of the arrivals
+   */
+  void SetEcn (bool useEcn, double markRatio, double signalPenalty);
+  /**
+   * \param minSize the smallest buffer size in packets an action may set
+   * \param maxSize the largest buffer size in packets an action may set
+   */
+  void SetSizeLimits (uint32_t minSize, uint32_t maxSize);
+
+  /**
+   * \brief Forget the slot and episode state
+   * \param bufferSize the current buffer size in packets
+   */
+  void Reset (uint32_t bufferSize);
+  /**
+   * \brief Start a new episode: clear the reward sum and the action counts only
+   */
+  void ResetEpisode (void);
+
+  void NotifyArrival (bool accepted);  //!< A packet arrived, accepted by the queue or dropped
+  void NotifyMark (void);              //!< A packet was ECN marked
+
+  /**
+   * \param backlog the queue size in packets before the arrival
+   * \return true if an arriving ECT packet must be marked
+   */
+  bool ShouldMark (uint32_t backlog) const
+  {
+    return m_useEcn && backlog >= m_markThreshold;
+  }
+
+  /**
+   * \brief Build the state of the slot that just ended
+   * \param packets the backlog in packets
+   * \param bytes the backlog in bytes
+   * \param bufferSize the buffer size in packets
+   * \param rate the estimated dequeue rate in bytes/s
+   * \param flows the per-flow table, nullptr if disabled
+   * \return queue size, rate in Mbps, delay in s and buffer size, followed by
+   *         the active flows and Jain index with a flow table and by the
+   *         slot drops and marks with ECN
+   */
+  observation_t GetObservation (uint32_t packets, uint32_t bytes, uint32_t bufferSize,
+                                double rate, const FlowTable* flows);
+  /**
+   * \param ob the observation of the decision
+   * \return the action of the embedded delay/drop heuristic
+   */
+  action_t NativeAction (const observation_t& ob) const;
+  /**
+   * \brief Apply an action and close the slot
+   * \param action 0 add, 1 keep, 2 reduce
+   * \param bufferSize the current buffer size in packets
+   * \param backlog the queue size in packets, a reduction never goes below it
+   * \return the new buffer size in packets
+   */
+  uint32_t ApplyAction (action_t action, uint32_t bufferSize, uint32_t backlog);
+  /**
+   * \brief Compute the reward of the last action, one slot after it
+   *
+   * Restarts the rate estimator after two slots well below the desired
+   * delay without a size change.
+   *
+   * \param packets the backlog in packets
+   * \param bytes the backlog in bytes
+   * \param bufferSize the buffer size in packets
+   * \param estimator the dequeue rate estimator
+   * \return the reward, clipped to [-1, 1]
+   */
+  float CalculateReward (uint32_t packets, uint32_t bytes, uint32_t bufferSize,
+                         RateEstimator& estimator);
+
+  /**
+   * \brief Buffer size after an action
+   * \param action 0 add, 1 keep, 2 reduce
+   * \param size the current buffer size
+   * \param backlog the queue size, a reduction never goes below it
+   * \param step the size change of one action
+   * \param minSize the smallest size
+   * \param maxSize the largest size
+   * \return the new buffer size
+   */
+  static uint32_t Resize (action_t action, uint32_t size, uint32_t backlog,
+                          uint32_t step, uint32_t minSize, uint32_t maxSize)
+  {
+    if (action == 0)
+      {
+        return size + step <= maxSize ? size + step : maxSize;
+      }
+    if (action == 2)
+      {
+        //Pay attention to queue length and minimum buffer size when reducing
+        uint32_t newSize = size >= backlog + step ? size - step : backlog;
+        return newSize >= minSize ? newSize : minSize;
+      }
+    return size;
+  }
+  /**
+   * \brief Reward of one slot
+   * \param delay the queueing delay in s
+   * \param desiredDelay the desired queueing delay in s
+   * \param congested true if arrivals were mostly accepted, the reward is then the occupancy
+   * \param occupancy the queue size over the buffer size
+   * \param signalPenalty the penalty per dropped or marked fraction of arrivals, 0 without ECN
+   * \param arrivals the arrivals of the slot
+   * \param signals the drops and marks of the slot
+   * \return the reward, clipped to [-1, 1]
+   */
+  static float Reward (double delay, double desiredDelay, bool congested, float occupancy,
+                       double signalPenalty, uint32_t arrivals, uint32_t signals)
+  {
+    float reward = congested ? occupancy : (float)(delay / desiredDelay);
+    if (signalPenalty > 0 && arrivals > 0)  //Drops and marks both cost the senders a window reduction
+      {
+        reward -= (float)(signalPenalty * signals / arrivals);
+      }
+    reward = reward > (float)-1.0 ? reward : (float)-1.0;  // Clipped by min / max value
+    return reward < (float)1.0 ? reward : (float)1.0;
+  }
+  /**
+   * \brief Action of the embedded delay/drop heuristic
+   * \param delay the observed queueing delay in s
+   * \param desiredDelay the desired queueing delay in s
+   * \param drops the drops of the slot
+   * \return 2 above the desired delay, 0 when dropping well below it, 1 otherwise
+   */
+  static action_t Native (double delay, double desiredDelay, uint32_t drops)
+  {
+    if (delay > desiredDelay)  //Too much standing queue
+      {
+        return 2;
+      }
+    if (drops > 0 && delay < 0.5 * desiredDelay)  //Dropping while the delay is still low
+      {
+        return 0;
+      }
+    return 1;
+  }
+  /**
+   * \param markRatio the marking threshold as a fraction of the buffer size
+   * \param size the buffer size
+   * \return the backlog from which ECT packets are marked, at least 1 so
+   *         that a small buffer does not mark arrivals into an empty queue
+   */
+  static uint32_t MarkThreshold (double markRatio, uint32_t size)
+  {
+    uint32_t threshold = (uint32_t)(markRatio * size);
+    return threshold > 0 ? threshold : 1;
+  }
+  /**
+   * \return true if the rate measurement should restart: two slots well
+   *         below the desired delay with a kept buffer size
+   */
+  static bool ShouldRestartRate (double delay, double oldDelay, double desiredDelay, action_t action, double rate)
+  {
+    return delay < 0.5 * desiredDelay && oldDelay < 0.5 * desiredDelay && action == 1 && rate > 0;
+  }
+
+  uint32_t GetMarkThreshold (void) const;
+  double GetQueueDelay (void) const;    //!< Delay of the last observation or reward, in s
+  uint32_t GetSlotArrivals (void) const;
+  uint32_t GetSlotDrops (void) const;
+  uint32_t GetSlotMarks (void) const;
+  float GetLastReward (void) const;
+  float GetRewardsSum (void) const;
+  uint32_t GetSteps (void) const;       //!< Rewards computed in the episode
+  /**
+   * \param action 0 add, 1 keep, 2 reduce
+   * \return the number of times the action was applied in the episode
+   */
+  uint32_t GetActionCount (action_t action) const;
+  uint32_t GetDecisionCount (void) const;
+
+private:
+  void UpdateMarkThreshold (uint32_t bufferSize);
+  double QueueDelay (uint32_t bytes, double rate) const;
+
+  double m_desiredQueueDelay;
+  bool m_useEcn;
+  double m_markRatio;
+  double m_signalPenalty;
+  uint32_t m_minSize;
+  uint32_t m_maxSize;
+
+  uint32_t m_markThreshold;   // Queue size above which ECT packets are marked
+  uint32_t m_enqueuedPacket;  // Accepted arrivals in the slot
+  uint32_t m_droppedPacket;   // Dropped arrivals in the slot
+  uint32_t m_markedPacket;    // ECN marks in the slot
+  int32_t m_congestion;       // Accepted minus rejected arrivals, within [-5, 5]
+  double m_currQueueDelay;
+  double m_oldQueueDelay;
+  action_t m_action;          // Action of the running slot
+  float m_singleReward;
+  float m_rewardsSum;
+  uint32_t m_steps;
+  uint32_t m_actionCount[3];
+};
+
+}
+
+#endif /* BUFFER_CONTROLLER_H */
@@ -0,0 +1,209 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "decision-stats.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <unistd.h>
+
+namespace ns3
+{
+
+static const char* g_stageNames[STAGE_COUNT] = {
+  "simulate", "serialize", "send", "agent", "parse", "decision"
+};
+
+DecisionStats::DecisionStats ()
+  : m_timelineEnabled (false),
+    m_origin (Now ())
+{
+  Reset ();
+}
+
+uint64_t
+DecisionStats::Now (void)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds> (
+           std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+const char*
+DecisionStats::GetStageName (DecisionStage stage)
+{
+  return stage < STAGE_COUNT ? g_stageNames[stage] : "unknown";
+}
+
+void
+DecisionStats::Record (DecisionStage stage, uint64_t start, uint64_t end)
+{
+  uint64_t duration = end > start ? end - start : 0;
+  StageCounters& s = m_stages[stage];
+
+  uint32_t bucket = 0;
+  for (uint64_t d = duration; d != 0 && bucket < HISTOGRAM_BUCKETS - 1; d >>= 1)
+    {
+      bucket++;
+    }
+  s.count.fetch_add (1, std::memory_order_relaxed);
+  s.total.fetch_add (duration, std::memory_order_relaxed);
+  s.buckets[bucket].fetch_add (1, std::memory_order_relaxed);
+  s.last.store (duration, std::memory_order_relaxed);
+  uint64_t max = s.max.load (std::memory_order_relaxed);
+  while (duration > max && !s.max.compare_exchange_weak (max, duration, std::memory_order_relaxed))
+    {
+    }
+
+  if (m_timelineEnabled && m_timeline.size () < TIMELINE_LIMIT)
+    {
+      m_timeline.push_back ({start, duration, stage});
+    }
+}
+
+void
+DecisionStats::EnableTimeline (bool enable)
+{
+  m_timelineEnabled = enable;
+}
+
+void
+DecisionStats::Reset (void)
+{
+  for (uint32_t i = 0; i < STAGE_COUNT; i++)
+    {
+      StageCounters& s = m_stages[i];
+      s.count.store (0, std::memory_order_relaxed);
+      s.total.store (0, std::memory_order_relaxed);
+      s.max.store (0, std::memory_order_relaxed);
+      s.last.store (0, std::memory_order_relaxed);
+      for (uint32_t b = 0; b < HISTOGRAM_BUCKETS; b++)
+        {
+          s.buckets[b].store (0, std::memory_order_relaxed);
+        }
+    }
+  m_timeline.clear ();
+  m_origin = Now ();
+}
+
+void
+DecisionStats::ClearLast (void)
+{
+  for (uint32_t i = 0; i < STAGE_COUNT; i++)
+    {
+      m_stages[i].last.store (0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t
+DecisionStats::GetCount (DecisionStage stage) const
+{
+  return m_stages[stage].count.load (std::memory_order_relaxed);
+}
+
+uint64_t
+DecisionStats::GetTotal (DecisionStage stage) const
+{
+  return m_stages[stage].total.load (std::memory_order_relaxed);
+}
+
+uint64_t
+DecisionStats::GetMax (DecisionStage stage) const
+{
+  return m_stages[stage].max.load (std::memory_order_relaxed);
+}
+
+uint64_t
+DecisionStats::GetLast (DecisionStage stage) const
+{
+  return m_stages[stage].last.load (std::memory_order_relaxed);
+}
+
+uint64_t
+DecisionStats::GetQuantile (DecisionStage stage, double q) const
+{
+  const StageCounters& s = m_stages[stage];
+  uint64_t count = s.count.load (std::memory_order_relaxed);
+  if (count == 0)
+    {
+      return 0;
+    }
+  uint64_t rank = (uint64_t)(q * count);
+  rank = rank < count ? rank : count - 1;
+  uint64_t seen = 0;
+  for (uint32_t b = 0; b < HISTOGRAM_BUCKETS; b++)
+    {
+      seen += s.buckets[b].load (std::memory_order_relaxed);
+      if (seen > rank)
+        {
+          uint64_t upper = b == 0 ? 0 : ((uint64_t)1 << b) - 1;
+          uint64_t max = GetMax (stage);
+          return upper < max ? upper : max;
+        }
+    }
+  return GetMax (stage);
+}
+
+void
+DecisionStats::Summary (std::ostream& os) const
+{
+  std::ios_base::fmtflags flags = os.flags ();
+  std::streamsize precision = os.precision ();
+  uint64_t all = 0;
+  for (uint32_t i = 0; i < STAGE_DECISION; i++)
+    {
+      all += GetTotal ((DecisionStage)i);
+    }
+
+  os << std::left << std::setw (10) << "stage" << std::right
+     << std::setw (10) << "count"
+     << std::setw (12) << "mean(us)"
+     << std::setw (12) << "p50(us)"
+     << std::setw (12) << "p99(us)"
+     << std::setw (12) << "max(us)"
+     << std::setw (9) << "share" << std::endl;
+  for (uint32_t i = 0; i < STAGE_COUNT; i++)
+    {
+      DecisionStage stage = (DecisionStage)i;
+      uint64_t count = GetCount (stage);
+      uint64_t total = GetTotal (stage);
+      os << std::left << std::setw (10) << GetStageName (stage) << std::right
+         << std::setw (10) << count
+         << std::fixed << std::setprecision (1)
+         << std::setw (12) << (count ? total / 1e3 / count : 0.0)
+         << std::setw (12) << GetQuantile (stage, 0.5) / 1e3
+         << std::setw (12) << GetQuantile (stage, 0.99) / 1e3
+         << std::setw (12) << GetMax (stage) / 1e3;
+      if (stage != STAGE_DECISION && all > 0)
+        {
+          os << std::setw (8) << 100.0 * total / all << "%";
+        }
+      os << std::endl;
+    }
+  os.flags (flags);
+  os.precision (precision);
+}
+
+bool
+DecisionStats::WriteChromeTrace (const std::string& fn) const
+{
+  FILE* f = std::fopen (fn.c_str (), "w");
+  if (!f)
+    {
+      return false;
+    }
+  int pid = getpid ();
+  std::fprintf (f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  for (size_t i = 0; i < m_timeline.size (); i++)
+    {
+      const TimelineEvent& e = m_timeline[i];
+      double ts = e.start >= m_origin ? (e.start - m_origin) / 1e3 : 0.0;
+      // Whole decisions go on their own row so the stages nest below them
+      std::fprintf (f, "%s{\"name\":\"%s\",\"cat\":\"decision\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d}\n",
+                    i == 0 ? "" : ",", GetStageName (e.stage), ts, e.duration / 1e3,
+                    pid, e.stage == STAGE_DECISION ? 0 : 1);
+    }
+  std::fprintf (f, "]}\n");
+  return std::fclose (f) == 0;
+}
+
+}
@@ -0,0 +1,121 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef DECISION_STATS_H
+#define DECISION_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Wall-clock stages of one agent decision.
+ */
+enum DecisionStage
+{
+  STAGE_SIMULATE = 0, //!< Simulation between the end of a decision and the next one
+  STAGE_SERIALIZE,    //!< Building and dumping the JSON state
+  STAGE_SEND,         //!< send() of the state on the agent socket
+  STAGE_AGENT,        //!< Waiting for the reply (agent compute and transport)
+  STAGE_PARSE,        //!< Parsing the received action
+  STAGE_DECISION,     //!< Whole decision, from observation to applied action
+  STAGE_COUNT
+};
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Per-instance latency counters and log2 histograms of the decision loop.
+ *
+ * Timestamps come from a monotonic clock in nanoseconds. Counters are
+ * relaxed atomics so they can be read from another thread while the
+ * simulation runs. The optional timeline keeps every recorded interval
+ * so it can be dumped as a Chrome trace (chrome://tracing, Perfetto).
+ */
+class DecisionStats
+{
+public:
+  static const uint32_t HISTOGRAM_BUCKETS = 48;       //!< Bucket i holds durations in [2^(i-1), 2^i) ns
+  static const uint32_t TIMELINE_LIMIT = 1u << 20;    //!< Maximum number of timeline events kept
+
+  DecisionStats ();
+
+  /**
+   * \return the current monotonic time in nanoseconds
+   */
+  static uint64_t Now (void);
+  /**
+   * \param stage the stage
+   * \return a short printable name of the stage
+   */
+  static const char* GetStageName (DecisionStage stage);
+
+  /**
+   * \brief Record one interval of a stage
+   * \param stage the stage
+   * \param start monotonic start time in ns, as returned by Now ()
+   * \param end monotonic end time in ns, as returned by Now ()
+   */
+  void Record (DecisionStage stage, uint64_t start, uint64_t end);
+
+  void EnableTimeline (bool enable);
+  void Reset (void);
+  /**
+   * \brief Zero the most recent durations, so that the stages a decision
+   *        skips do not report those of an earlier one
+   */
+  void ClearLast (void);
+
+  uint64_t GetCount (DecisionStage stage) const;
+  uint64_t GetTotal (DecisionStage stage) const;  //!< Sum of durations in ns
+  uint64_t GetMax (DecisionStage stage) const;    //!< Longest duration in ns
+  uint64_t GetLast (DecisionStage stage) const;   //!< Most recent duration in ns
+  /**
+   * \param stage the stage
+   * \param q the quantile in [0, 1]
+   * \return the upper bound in ns of the histogram bucket holding the quantile
+   */
+  uint64_t GetQuantile (DecisionStage stage, double q) const;
+
+  /**
+   * \brief Print one line per stage with count, mean, p50, p99, max and share of time
+   * \param os the output stream
+   */
+  void Summary (std::ostream& os) const;
+  /**
+   * \brief Write the timeline in Chrome trace event JSON format
+   * \param fn the output file name
+   * \return false if the file could not be written
+   */
+  bool WriteChromeTrace (const std::string& fn) const;
+
+private:
+  struct StageCounters
+  {
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> max;
+    std::atomic<uint64_t> last;
+    std::atomic<uint64_t> buckets[HISTOGRAM_BUCKETS];
+  };
+  struct TimelineEvent
+  {
+    uint64_t start;
+    uint64_t duration;
+    DecisionStage stage;
+  };
+
+  StageCounters m_stages[STAGE_COUNT];
+  bool m_timelineEnabled;
+  uint64_t m_origin;  // Monotonic time the timeline is relative to
+  std::vector<TimelineEvent> m_timeline;
+};
+
+}
+
+#endif /* DECISION_STATS_H */
@@ -0,0 +1,196 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "flow-table.h"
+
+namespace ns3
+{
+
+FlowTable::FlowTable ()
+  : m_mask (0),
+    m_ageTimeout (1000000000),
+    m_slot (1),
+    m_activeFlows (0),
+    m_sumBytes (0),
+    m_sumSqBytes (0),
+    m_evictions (0),
+    m_overflows (0)
+{
+}
+
+void
+FlowTable::SetCapacity (uint32_t capacity)
+{
+  uint32_t size = 0;
+  if (capacity > 0)
+    {
+      size = 1;
+      while (size < capacity)
+        {
+          size <<= 1;
+        }
+    }
+  m_entries.assign (size, Entry ());
+  m_mask = size > 0 ? size - 1 : 0;
+  m_slot = 1;
+  m_activeFlows = 0;
+  m_sumBytes = 0;
+  m_sumSqBytes = 0;
+  m_evictions = 0;
+  m_overflows = 0;
+}
+
+void
+FlowTable::SetAgeTimeout (uint64_t timeout)
+{
+  m_ageTimeout = timeout;
+}
+
+uint32_t
+FlowTable::GetCapacity (void) const
+{
+  return m_entries.size ();
+}
+
+FlowTable::Entry*
+FlowTable::Touch (uint32_t hash, uint64_t now)
+{
+  if (m_entries.empty ())
+    {
+      return nullptr;
+    }
+
+  Entry* free = nullptr;
+  for (uint32_t p = 0; p < MAX_PROBE && p <= m_mask; p++)
+    {
+      Entry& e = m_entries[(hash + p) & m_mask];
+      if (e.used && e.hash == hash)
+        {
+          free = &e;
+          break;
+        }
+      // Keep probing past an aged entry, the flow may sit further in the chain.
+      // Entries are never emptied, so an unused one ends the chain.
+      if (!e.used)
+        {
+          free = free ? free : &e;
+          break;
+        }
+      if (!free && now - e.lastSeen > m_ageTimeout)
+        {
+          free = &e;
+        }
+    }
+
+  if (!free)
+    {
+      m_overflows++;
+      return nullptr;
+    }
+  if (!free->used || free->hash != hash)
+    {
+      if (free->used)
+        {
+          m_evictions++;
+        }
+      *free = Entry ();
+      free->hash = hash;
+      free->used = true;
+    }
+  if (free->slot != m_slot)
+    {
+      free->slot = m_slot;
+      free->slotBytes = 0;
+      free->slotDrops = 0;
+      m_activeFlows++;
+    }
+  free->lastSeen = now;
+  return free;
+}
+
+void
+FlowTable::NotifyEnqueue (uint32_t hash, uint64_t now)
+{
+  Touch (hash, now);
+}
+
+void
+FlowTable::NotifyDrop (uint32_t hash, uint64_t now)
+{
+  Entry* e = Touch (hash, now);
+  if (e)
+    {
+      e->drops++;
+      e->slotDrops++;
+    }
+}
+
+void
+FlowTable::NotifyDequeue (uint32_t hash, uint32_t bytes, uint64_t now)
+{
+  Entry* e = Touch (hash, now);
+  if (e)
+    {
+      double old = (double)e->slotBytes;
+      e->bytes += bytes;
+      e->slotBytes += bytes;
+      m_sumBytes += bytes;
+      m_sumSqBytes += (double)e->slotBytes * e->slotBytes - old * old;
+    }
+}
+
+void
+FlowTable::NewSlot (void)
+{
+  m_slot++;
+  m_activeFlows = 0;
+  m_sumBytes = 0;
+  m_sumSqBytes = 0;
+}
+
+uint32_t
+FlowTable::GetActiveFlows (void) const
+{
+  return m_activeFlows;
+}
+
+double
+FlowTable::GetJainIndex (void) const
+{
+  if (m_activeFlows == 0 || m_sumSqBytes <= 0)
+    {
+      return 1.0;
+    }
+  return (m_sumBytes * m_sumBytes) / (m_activeFlows * m_sumSqBytes);
+}
+
+const FlowTable::Entry*
+FlowTable::Find (uint32_t hash) const
+{
+  for (uint32_t p = 0; p < MAX_PROBE && p < m_entries.size (); p++)
+    {
+      const Entry& e = m_entries[(hash + p) & m_mask];
+      if (!e.used)
+        {
+          return nullptr;
+        }
+      if (e.hash == hash)
+        {
+          return &e;
+        }
+    }
+  return nullptr;
+}
+
+uint64_t
+FlowTable::GetEvictions (void) const
+{
+  return m_evictions;
+}
+
+uint64_t
+FlowTable::GetOverflows (void) const
+{
+  return m_overflows;
+}
+
+}
@@ -0,0 +1,98 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef FLOW_TABLE_H
+#define FLOW_TABLE_H
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Fixed-capacity per-flow accounting table keyed by a flow hash.
+ *
+ * The table is open addressing with linear probing over a power of two
+ * number of entries, allocated once by SetCapacity. Every update looks at
+ * no more than MAX_PROBE entries and never allocates. Entries not seen for
+ * the age timeout are reused by new flows; when the probe window holds no
+ * free or aged entry the packet is only counted as an overflow.
+ *
+ * Activity is also accumulated per measurement slot: the number of flows
+ * active in the slot and the sum and sum of squares of their dequeued
+ * bytes, from which Jain's fairness index is derived in O(1).
+ */
+class FlowTable
+{
+public:
+  static const uint32_t MAX_PROBE = 8;  //!< Maximum entries inspected per lookup
+
+  struct Entry
+  {
+    uint32_t hash;       //!< Flow hash
+    bool used;           //!< True once the entry holds a flow
+    uint32_t slot;       //!< Last slot the flow was active in
+    uint64_t lastSeen;   //!< Last activity time in ns
+    uint64_t bytes;      //!< Dequeued bytes since the flow was inserted
+    uint32_t drops;      //!< Dropped packets since the flow was inserted
+    uint64_t slotBytes;  //!< Dequeued bytes in the last active slot
+    uint32_t slotDrops;  //!< Dropped packets in the last active slot
+  };
+
+  FlowTable ();
+
+  /**
+   * \brief Allocate the table and forget all flows
+   * \param capacity the number of entries, rounded up to a power of two. 0 frees the table
+   */
+  void SetCapacity (uint32_t capacity);
+  /**
+   * \param timeout time in ns after which an idle flow may be evicted
+   */
+  void SetAgeTimeout (uint64_t timeout);
+  uint32_t GetCapacity (void) const;
+
+  void NotifyEnqueue (uint32_t hash, uint64_t now);
+  void NotifyDrop (uint32_t hash, uint64_t now);
+  void NotifyDequeue (uint32_t hash, uint32_t bytes, uint64_t now);
+
+  /**
+   * \brief Close the current measurement slot and start a new one
+   */
+  void NewSlot (void);
+  /**
+   * \return the number of flows active in the current slot
+   */
+  uint32_t GetActiveFlows (void) const;
+  /**
+   * \return Jain's fairness index of the bytes dequeued per active flow in
+   *         the current slot, 1 if there is no active flow
+   */
+  double GetJainIndex (void) const;
+  /**
+   * \param hash the flow hash
+   * \return the entry of the flow, or nullptr if it is not tracked
+   */
+  const Entry* Find (uint32_t hash) const;
+
+  uint64_t GetEvictions (void) const;  //!< Aged flows replaced by new ones
+  uint64_t GetOverflows (void) const;  //!< Packets of flows that found no entry
+
+private:
+  Entry* Touch (uint32_t hash, uint64_t now);
+
+  std::vector<Entry> m_entries;
+  uint32_t m_mask;
+  uint64_t m_ageTimeout;
+  uint32_t m_slot;
+  uint32_t m_activeFlows;
+  double m_sumBytes;
+  double m_sumSqBytes;
+  uint64_t m_evictions;
+  uint64_t m_overflows;
+};
+
+}
+
+#endif /* FLOW_TABLE_H */
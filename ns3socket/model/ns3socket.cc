@@ -2,42 +2,222 @@
 
 #include "ns3socket.h"
 
+#include <cerrno>
+#include <cmath>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+
 namespace ns3
 {
+static const int64_t RECONNECT_MIN_BACKOFF = 100000000;     //100 ms
+static const int64_t RECONNECT_MAX_BACKOFF = 10000000000;   //10 s
+
 NS3Client::NS3Client(){
-    sock_client = socket(AF_INET, SOCK_STREAM, 0);
-    sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(8888);
-    connect(sock_client, (sockaddr*)&server_addr, sizeof(sockaddr));
+    Init("127.0.0.1", 8888);
 }
 NS3Client::NS3Client(int port){
-    sock_client = socket(AF_INET, SOCK_STREAM, 0);
-    sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-    connect(sock_client, (sockaddr*)&server_addr, sizeof(sockaddr));
+    Init("127.0.0.1", port);
 }
 
 NS3Client::NS3Client(const char* ipaddress,int port){
+    Init(ipaddress, port);
+}
+
+NS3Client::~NS3Client(){
+    CloseClient();
+}
+
+void 
+NS3Client::Init(const char* ipaddress, int port){
+    m_stats = nullptr;
+    m_address = ipaddress;
+    m_port = port;
+    sock_client = -1;
+    m_connecting = false;
+    m_everConnected = false;
+    m_pending = false;
+    m_deadline = -1;
+    m_hangTimeout = 5000000000;
+    m_decisionEnd = -1;
+    m_sentAt = 0;
+    m_nextAttempt = 0;
+    m_backoff = RECONNECT_MIN_BACKOFF;
+    m_missedDeadlines = 0;
+    m_reconnects = 0;
+    m_snapshotRequested = false;
+    Connect();
+}
+
+bool 
+NS3Client::Connect(){
     sock_client = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock_client < 0) {
+        Disconnect();
+        return false;
+    }
+    fcntl(sock_client, F_SETFL, fcntl(sock_client, F_GETFL, 0) | O_NONBLOCK);
+    int one = 1;    //States are small, do not let Nagle hold them back
+    setsockopt(sock_client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
     sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_addr.s_addr = inet_addr(ipaddress);
+    server_addr.sin_addr.s_addr = inet_addr(m_address.c_str());
     server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-    connect(sock_client, (sockaddr*)&server_addr, sizeof(sockaddr));
+    server_addr.sin_port = htons(m_port);
+    if (connect(sock_client, (sockaddr*)&server_addr, sizeof(sockaddr)) == 0 || errno == EINPROGRESS) {
+        m_connecting = true;
+        return true;
+    }
+    Disconnect();
+    return false;
+}
+
+bool 
+NS3Client::EnsureConnected(int64_t deadlineAt){
+    if (sock_client < 0) {
+        if (DecisionStats::Now() < (uint64_t)m_nextAttempt || !Connect()) {
+            return false;
+        }
+    }
+    if (m_connecting) {
+        if (!WaitFor(POLLOUT, deadlineAt)) {
+            return false;   //Still connecting, check again at the next decision
+        }
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (getsockopt(sock_client, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+            Disconnect();
+            return false;
+        }
+        m_connecting = false;
+        if (m_everConnected) {
+            m_reconnects++;
+        }
+        m_everConnected = true;
+        m_backoff = RECONNECT_MIN_BACKOFF;
+    }
+    return true;
 }
+
 void 
+NS3Client::Disconnect(){
+    if (sock_client >= 0) {
+        close(sock_client);
+    }
+    sock_client = -1;
+    m_connecting = false;
+    m_pending = false;
+    m_recvBuffer.clear();
+    m_nextAttempt = DecisionStats::Now() + m_backoff;
+    m_backoff = std::min(2 * m_backoff, RECONNECT_MAX_BACKOFF);
+}
+
+bool 
+NS3Client::WaitFor(short events, int64_t deadlineAt){
+    pollfd pfd = {sock_client, events, 0};
+    while (true) {
+        int timeout = -1;
+        if (deadlineAt >= 0) {
+            int64_t left = deadlineAt - (int64_t)DecisionStats::Now();
+            timeout = left > 0 ? (int)((left + 999999) / 1000000) : 0;   //Round up to ms
+        }
+        int ret = poll(&pfd, 1, timeout);
+        if (ret > 0) {
+            return true;    //Errors and hang-ups are reported by the following call
+        }
+        if (ret == 0 || errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+bool 
+NS3Client::SendAll(const char* data, size_t length, int64_t deadlineAt){
+    while (length > 0) {
+        ssize_t n = send(sock_client, data, length, MSG_NOSIGNAL);
+        if (n > 0) {
+            data += n;
+            length -= n;
+        }
+        else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            if (!WaitFor(POLLOUT, deadlineAt)) {
+                Disconnect();   //A partial state would corrupt the stream
+                return false;
+            }
+        }
+        else {
+            Disconnect();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool 
+NS3Client::ReadMessage(int64_t deadlineAt, std::string& message){
+    while (true) {
+        size_t end = m_recvBuffer.find('\0');
+        if (end != std::string::npos) {     //Replies are NUL terminated
+            message = m_recvBuffer.substr(0, end);
+            m_recvBuffer.erase(0, end + 1);
+            return true;
+        }
+        char recv_info[256];
+        ssize_t n = recv(sock_client, recv_info, sizeof(recv_info), 0);
+        if (n > 0) {
+            m_recvBuffer.append(recv_info, n);
+        }
+        else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            if (!WaitFor(POLLIN, deadlineAt)) {
+                return false;
+            }
+        }
+        else {
+            Disconnect();   //Agent closed the connection
+            return false;
+        }
+    }
+}
+
+bool 
+NS3Client::DrainLateReply(){
+    std::string late;
+    while (ReadMessage(0, late)) {
+        if (late == "snapshot") {   //The request still holds, the action after it does not
+            m_snapshotRequested = true;
+            continue;
+        }
+        m_pending = false;  //The late action is stale, drop it
+        return true;
+    }
+    if (sock_client >= 0 && (int64_t)DecisionStats::Now() - m_sentAt > m_hangTimeout) {
+        Disconnect();   //Agent looks hung, start over with a new connection
+    }
+    return false;
+}
+
+bool 
 NS3Client::SendData(char* sendData){
-    send(sock_client, sendData, strlen(sendData) + 1, 0);
+    int64_t deadlineAt = m_deadline < 0 ? -1 : DecisionStats::Now() + m_deadline;
+    if (!EnsureConnected(deadlineAt)) {
+        return false;
+    }
+    return SendAll(sendData, strlen(sendData) + 1, deadlineAt);
 }
-void 
+
+bool 
 NS3Client::SendData(DRLstate* sendData){
+    uint64_t t0 = DecisionStats::Now();
+    m_decisionEnd = m_deadline < 0 ? -1 : t0 + m_deadline;
+    //Not sent while connecting or while the agent is still busy with an earlier state
+    if (!EnsureConnected(m_decisionEnd) || (m_pending && !DrainLateReply())) {
+        if (m_stats) {
+            m_stats->Record(STAGE_SEND, t0, DecisionStats::Now());
+        }
+        return false;
+    }
+
     nlohmann::json json_data = {    //Convert data to JSON format and send it
         {"a", sendData->a},
         {"b", sendData->b},
@@ -46,23 +226,113 @@ NS3Client::SendData(DRLstate* sendData){
         {"reward", sendData->reward},
         {"done", sendData->done}
     };
+    if (!sendData->extra.empty()) {
+        json_data["extra"] = sendData->extra;
+    }
     std::string serialized_data = json_data.dump();
-    send(sock_client, serialized_data.c_str(), serialized_data.length(), 0);
+    uint64_t t1 = DecisionStats::Now();
+    bool sent = SendAll(serialized_data.c_str(), serialized_data.length(), m_decisionEnd);
+    m_sentAt = DecisionStats::Now();
+    if (m_stats) {
+        m_stats->Record(STAGE_SERIALIZE, t0, t1);
+        m_stats->Record(STAGE_SEND, t1, m_sentAt);
+    }
+    return sent;
+}
+
+bool 
+NS3Client::RecvData(float& action){
+    uint64_t t0 = m_stats ? DecisionStats::Now() : 0;
+    if (sock_client < 0 || m_connecting || m_pending) {
+        if (m_stats) {
+            m_stats->Record(STAGE_AGENT, t0, t0);   //Nothing sent, nothing to wait for
+        }
+        return false;
+    }
+    std::string recv_info;
+    bool received = ReadMessage(m_decisionEnd, recv_info);
+    while (received && recv_info == "snapshot") {   //Agent asks for a snapshot, the action follows
+        m_snapshotRequested = true;
+        received = ReadMessage(m_decisionEnd, recv_info);
+    }
+    uint64_t t1 = m_stats ? DecisionStats::Now() : 0;
+    if (m_stats) {  //Timeouts and errors count up to the moment they are detected
+        m_stats->Record(STAGE_AGENT, t0, t1);
+    }
+    if (!received) {
+        if (sock_client >= 0) {     //Timed out, the reply is read and dropped later
+            m_pending = true;
+            m_missedDeadlines++;
+        }
+        return false;
+    }
+
+    char* end = nullptr;
+    float received_action = strtof(recv_info.c_str(), &end);
+    bool valid = end != recv_info.c_str() && std::isfinite(received_action);
+    if (m_stats) {
+        m_stats->Record(STAGE_PARSE, t1, DecisionStats::Now());
+    }
+    if (!valid) {
+        Disconnect();   //Not our protocol, resynchronize on a new connection
+        return false;
+    }
+    action = received_action;
+    return true;
 }
 
 float 
 NS3Client::RecvData(){
-    char recv_info[50];
-    recv(sock_client, recv_info, sizeof(recv_info), 0);
-    float received_action = std::stof(recv_info);
-    return received_action;
+    float action = -1;
+    RecvData(action);
+    return action;
 }
 
 void 
 NS3Client::CloseClient(){
-    close(sock_client);
+    if (sock_client >= 0) {
+        close(sock_client);
+    }
+    sock_client = -1;
+    m_connecting = false;
+    m_pending = false;
+}
+
+void 
+NS3Client::SetStats(DecisionStats* stats){
+    m_stats = stats;
 }
 
+void 
+NS3Client::SetDeadline(int64_t deadline){
+    m_deadline = deadline;
 }
 
+void 
+NS3Client::SetHangTimeout(int64_t timeout){
+    m_hangTimeout = timeout;
+}
 
+bool 
+NS3Client::IsConnected() const{
+    return sock_client >= 0 && !m_connecting;
+}
+
+uint64_t 
+NS3Client::GetMissedDeadlines() const{
+    return m_missedDeadlines;
+}
+
+uint64_t 
+NS3Client::GetReconnects() const{
+    return m_reconnects;
+}
+
+bool 
+NS3Client::TakeSnapshotRequest(){
+    bool requested = m_snapshotRequested;
+    m_snapshotRequested = false;
+    return requested;
+}
+
+}
@@ -11,7 +11,10 @@
 #include <sys/socket.h>
 #include <unistd.h>
 #include <iostream>
+#include <string>
+#include <vector>
 #include <nlohmann/json.hpp>
+#include "decision-stats.h"
 // Add a doxygen group for this module.
 // If you have more than one file, this should be in only one of them.
 /**
@@ -28,6 +31,7 @@ struct DRLstate {
     float d;
     float reward;
     bool done;
+    std::vector<float> extra;   //Optional features after a-d, sent only when not empty
 };
 
 class NS3Client{
@@ -35,12 +39,48 @@ public:
     NS3Client();    //Initialize classes with different parameters
     NS3Client(int port);
     NS3Client(const char* ipaddress, int port);
-    void SendData(char* sendData); //Send data
-    void SendData(DRLstate* sendData);
-    float RecvData();   //Receive data
+    ~NS3Client();
+    NS3Client(const NS3Client&) = delete;   //Owns the socket, a copy would close it twice
+    NS3Client& operator=(const NS3Client&) = delete;
+    bool SendData(char* sendData); //Send data, false if it could not be sent
+    bool SendData(DRLstate* sendData);
+    bool RecvData(float& action);   //Receive an action, false on missed deadline or error or if nothing was sent
+    float RecvData();   //Receive data, -1 on missed deadline or error
     void CloseClient();
+    void SetStats(DecisionStats* stats);   //Record per-stage latency, nullptr disables it
+    void SetDeadline(int64_t deadline);   //Wall-clock budget in ns from SendData to the reply, negative blocks
+    void SetHangTimeout(int64_t timeout); //Reconnect if a reply is this late in ns
+    bool IsConnected() const;
+    uint64_t GetMissedDeadlines() const;  //Replies that did not arrive within the deadline
+    uint64_t GetReconnects() const;   //Successful connections after the first one
+    bool TakeSnapshotRequest();   //True once after the agent sent "snapshot" ahead of an action
 private:
+    void Init(const char* ipaddress, int port);
+    bool Connect();   //Start a non-blocking connect
+    bool EnsureConnected(int64_t deadlineAt);
+    void Disconnect();    //Close and schedule a reconnect with backoff
+    bool WaitFor(short events, int64_t deadlineAt);
+    bool SendAll(const char* data, size_t length, int64_t deadlineAt);
+    bool ReadMessage(int64_t deadlineAt, std::string& message);
+    bool DrainLateReply();
+
     int sock_client;
+    DecisionStats* m_stats;
+    std::string m_address;
+    int m_port;
+    bool m_connecting;    //Non-blocking connect in progress
+    bool m_everConnected;
+    bool m_pending;   //A reply missed its deadline and has not been read yet
+    std::string m_recvBuffer;   //Bytes received after the last complete reply
+    int64_t m_deadline;
+    int64_t m_hangTimeout;
+    int64_t m_decisionEnd;    //Absolute deadline of the current decision, negative for none
+    int64_t m_sentAt;   //Time the last state was sent
+    int64_t m_nextAttempt;    //Earliest time of the next connection attempt
+    int64_t m_backoff;
+    uint64_t m_missedDeadlines;
+    uint64_t m_reconnects;
+    bool m_snapshotRequested;
 };
 
 // Each class should be documented using Doxygen,
@@ -0,0 +1,295 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "packet-trace.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+namespace
+{
+
+const uint32_t PCAP_MAGIC_US = 0xa1b2c3d4;
+const uint32_t PCAP_MAGIC_NS = 0xa1b23c4d;
+const uint32_t LINKTYPE_ETHERNET = 1;
+const uint32_t LINKTYPE_RAW = 101;
+const uint32_t LINKTYPE_LINUX_SLL = 113;
+const uint32_t LINKTYPE_IPV4 = 228;
+const uint32_t LINKTYPE_IPV6 = 229;
+
+uint32_t
+ReadLe32 (const uint8_t* p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint32_t
+Swap32 (uint32_t v)
+{
+  return ((v & 0xff) << 24) | ((v & 0xff00) << 8) | ((v >> 8) & 0xff00) | (v >> 24);
+}
+
+/// FNV-1a over a byte range, chained through hash
+uint32_t
+Fnv1a (uint32_t hash, const uint8_t* p, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      hash = (hash ^ p[i]) * 16777619u;
+    }
+  return hash;
+}
+
+}
+
+PacketTrace::~PacketTrace ()
+{
+}
+
+BinaryPacketTrace::BinaryPacketTrace ()
+  : m_file (nullptr),
+    m_first (true),
+    m_start (0)
+{
+}
+
+BinaryPacketTrace::~BinaryPacketTrace ()
+{
+  if (m_file)
+    {
+      std::fclose (m_file);
+    }
+}
+
+bool
+BinaryPacketTrace::Open (const std::string& fileName)
+{
+  m_file = std::fopen (fileName.c_str (), "rb");
+  m_first = true;
+  return m_file != nullptr;
+}
+
+bool
+BinaryPacketTrace::Next (TracePacket& packet)
+{
+  uint8_t record[16];
+  if (!m_file || std::fread (record, 1, sizeof (record), m_file) != sizeof (record))
+    {
+      return false;
+    }
+  uint64_t time = ReadLe32 (record) | ((uint64_t)ReadLe32 (record + 4) << 32);
+  if (m_first)
+    {
+      m_start = time;
+      m_first = false;
+    }
+  packet.time = time >= m_start ? time - m_start : 0;
+  packet.size = ReadLe32 (record + 8);
+  packet.hash = ReadLe32 (record + 12);
+  return true;
+}
+
+bool
+BinaryPacketTrace::Write (FILE* f, const TracePacket& packet)
+{
+  uint8_t record[16];
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      record[i] = (uint8_t)(packet.time >> (8 * i));
+    }
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      record[8 + i] = (uint8_t)(packet.size >> (8 * i));
+      record[12 + i] = (uint8_t)(packet.hash >> (8 * i));
+    }
+  return std::fwrite (record, 1, sizeof (record), f) == sizeof (record);
+}
+
+PcapPacketTrace::PcapPacketTrace ()
+  : m_file (nullptr),
+    m_swapped (false),
+    m_nanoseconds (false),
+    m_linkType (0),
+    m_first (true),
+    m_start (0)
+{
+}
+
+PcapPacketTrace::~PcapPacketTrace ()
+{
+  if (m_file)
+    {
+      std::fclose (m_file);
+    }
+}
+
+bool
+PcapPacketTrace::IsPcap (const std::string& fileName)
+{
+  FILE* f = std::fopen (fileName.c_str (), "rb");
+  if (!f)
+    {
+      return false;
+    }
+  uint8_t magic[4];
+  bool pcap = std::fread (magic, 1, 4, f) == 4;
+  std::fclose (f);
+  if (!pcap)
+    {
+      return false;
+    }
+  uint32_t m = ReadLe32 (magic);
+  return m == PCAP_MAGIC_US || m == PCAP_MAGIC_NS || Swap32 (m) == PCAP_MAGIC_US || Swap32 (m) == PCAP_MAGIC_NS;
+}
+
+uint32_t
+PcapPacketTrace::Read32 (const uint8_t* p) const
+{
+  uint32_t v = ReadLe32 (p);
+  return m_swapped ? Swap32 (v) : v;
+}
+
+bool
+PcapPacketTrace::Open (const std::string& fileName)
+{
+  m_file = std::fopen (fileName.c_str (), "rb");
+  uint8_t header[24];
+  if (!m_file || std::fread (header, 1, sizeof (header), m_file) != sizeof (header))
+    {
+      return false;
+    }
+  uint32_t magic = ReadLe32 (header);
+  m_swapped = magic != PCAP_MAGIC_US && magic != PCAP_MAGIC_NS;
+  magic = m_swapped ? Swap32 (magic) : magic;
+  if (magic != PCAP_MAGIC_US && magic != PCAP_MAGIC_NS)
+    {
+      return false;
+    }
+  m_nanoseconds = magic == PCAP_MAGIC_NS;
+  m_linkType = Read32 (header + 20) & 0xffff;
+  m_first = true;
+  return m_linkType == LINKTYPE_ETHERNET || m_linkType == LINKTYPE_RAW || m_linkType == LINKTYPE_LINUX_SLL
+         || m_linkType == LINKTYPE_IPV4 || m_linkType == LINKTYPE_IPV6;
+}
+
+bool
+PcapPacketTrace::Next (TracePacket& packet)
+{
+  uint8_t header[16];
+  if (!m_file || std::fread (header, 1, sizeof (header), m_file) != sizeof (header))
+    {
+      return false;
+    }
+  uint64_t time = (uint64_t)Read32 (header) * 1000000000 + (uint64_t)Read32 (header + 4) * (m_nanoseconds ? 1 : 1000);
+  uint32_t captured = Read32 (header + 8);
+  uint32_t original = Read32 (header + 12);
+
+  // Only the headers are needed, skip the rest of the payload
+  uint32_t n = std::min<uint32_t> (captured, sizeof (m_buffer));
+  if (std::fread (m_buffer, 1, n, m_file) != n
+      || (captured > n && std::fseek (m_file, captured - n, SEEK_CUR) != 0))
+    {
+      return false;
+    }
+
+  uint32_t offset = 0;
+  uint16_t etherType = 0;
+  if (m_linkType == LINKTYPE_ETHERNET)
+    {
+      offset = 14;
+      etherType = n >= 14 ? (m_buffer[12] << 8) | m_buffer[13] : 0;
+      if (etherType == 0x8100 && n >= 18)
+        {
+          offset = 18;
+          etherType = (m_buffer[16] << 8) | m_buffer[17];
+        }
+    }
+  else if (m_linkType == LINKTYPE_LINUX_SLL)
+    {
+      offset = 16;
+      etherType = n >= 16 ? (m_buffer[14] << 8) | m_buffer[15] : 0;
+    }
+  bool ip = (m_linkType != LINKTYPE_ETHERNET && m_linkType != LINKTYPE_LINUX_SLL)
+            || etherType == 0x0800 || etherType == 0x86dd;
+
+  if (m_first)
+    {
+      m_start = time;
+      m_first = false;
+    }
+  packet.time = time >= m_start ? time - m_start : 0;
+  packet.size = original > offset ? original - offset : 1;
+  packet.hash = ip && n > offset ? HashPacket (m_buffer + offset, n - offset) : 0;
+  return true;
+}
+
+uint32_t
+PcapPacketTrace::HashPacket (const uint8_t* ip, uint32_t length) const
+{
+  uint32_t hash = 2166136261u;
+  uint8_t protocol;
+  uint32_t l4;
+  if ((ip[0] >> 4) == 4 && length >= 20)
+    {
+      protocol = ip[9];
+      l4 = (ip[0] & 0x0f) * 4;
+      hash = Fnv1a (hash, ip + 12, 8);
+    }
+  else if ((ip[0] >> 4) == 6 && length >= 40)
+    {
+      protocol = ip[6];
+      l4 = 40;
+      hash = Fnv1a (hash, ip + 8, 32);
+    }
+  else
+    {
+      return 0;
+    }
+  hash = Fnv1a (hash, &protocol, 1);
+  if ((protocol == 6 || protocol == 17) && length >= l4 + 4)
+    {
+      hash = Fnv1a (hash, ip + l4, 4);
+    }
+  return hash;
+}
+
+PoissonPacketTrace::PoissonPacketTrace (double rate, uint32_t size, uint32_t flows, double duration, uint32_t seed)
+  : m_rng (seed),
+    m_gap (rate > 0 ? rate : 1.0),
+    m_flow (1, flows > 0 ? flows : 1),
+    m_size (size),
+    m_duration (duration),
+    m_now (0)
+{
+}
+
+bool
+PoissonPacketTrace::Next (TracePacket& packet)
+{
+  m_now += m_gap (m_rng);
+  if (m_now > m_duration)
+    {
+      return false;
+    }
+  packet.time = (uint64_t)(m_now * 1e9);
+  packet.size = m_size;
+  packet.hash = m_flow (m_rng);
+  return true;
+}
+
+std::unique_ptr<PacketTrace>
+OpenPacketTrace (const std::string& fileName)
+{
+  if (PcapPacketTrace::IsPcap (fileName))
+    {
+      PcapPacketTrace* pcap = new PcapPacketTrace ();
+      std::unique_ptr<PacketTrace> trace (pcap);
+      return pcap->Open (fileName) ? std::move (trace) : nullptr;
+    }
+  BinaryPacketTrace* binary = new BinaryPacketTrace ();
+  std::unique_ptr<PacketTrace> trace (binary);
+  return binary->Open (fileName) ? std::move (trace) : nullptr;
+}
+
+}
@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef PACKET_TRACE_H
+#define PACKET_TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace ns3
+{
+
+/**
+ * \ingroup NS3Socket
+ *
+ * One packet arrival of a trace.
+ */
+struct TracePacket
+{
+  uint64_t time;  //!< Arrival time in ns since the first packet of the trace
+  uint32_t size;  //!< Size in bytes at the IP layer
+  uint32_t hash;  //!< Flow hash, 0 if unknown
+};
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Source of packet arrivals in time order.
+ */
+class PacketTrace
+{
+public:
+  virtual ~PacketTrace ();
+
+  /**
+   * \param [out] packet the next arrival
+   * \return false at the end of the trace
+   */
+  virtual bool Next (TracePacket& packet) = 0;
+};
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Binary trace: a sequence of 16-byte little-endian records, a uint64 time
+ * in ns, a uint32 size in bytes and a uint32 flow hash. Times are rebased
+ * on the first record.
+ */
+class BinaryPacketTrace : public PacketTrace
+{
+public:
+  BinaryPacketTrace ();
+  virtual ~BinaryPacketTrace ();
+
+  /**
+   * \param fileName the trace file
+   * \return false if the file cannot be opened
+   */
+  bool Open (const std::string& fileName);
+  virtual bool Next (TracePacket& packet);
+
+  /**
+   * \brief Append one record to a binary trace
+   * \param f the output file
+   * \param packet the arrival
+   * \return false on a write error
+   */
+  static bool Write (FILE* f, const TracePacket& packet);
+
+private:
+  FILE* m_file;
+  bool m_first;
+  uint64_t m_start;
+};
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Classic pcap capture, with microsecond or nanosecond timestamps in either
+ * byte order. Ethernet (with one VLAN tag), Linux cooked and raw IP link
+ * types are understood. The size is the original IP packet length and the
+ * flow hash covers the addresses, the protocol and, for TCP and UDP, the
+ * ports. Other packets get the hash 0.
+ */
+class PcapPacketTrace : public PacketTrace
+{
+public:
+  PcapPacketTrace ();
+  virtual ~PcapPacketTrace ();
+
+  /**
+   * \param fileName the capture file
+   * \return false if the file cannot be opened or is not a supported pcap
+   */
+  bool Open (const std::string& fileName);
+  virtual bool Next (TracePacket& packet);
+
+  /**
+   * \param fileName the file to check
+   * \return true if the file starts with a pcap magic number
+   */
+  static bool IsPcap (const std::string& fileName);
+
+private:
+  uint32_t Read32 (const uint8_t* p) const;
+  uint32_t HashPacket (const uint8_t* ip, uint32_t length) const;
+
+  FILE* m_file;
+  bool m_swapped;       // File byte order differs from little-endian
+  bool m_nanoseconds;   // Timestamps in ns instead of us
+  uint32_t m_linkType;
+  bool m_first;
+  uint64_t m_start;
+  uint8_t m_buffer[128];  // Captured headers of the current record
+};
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Synthetic Poisson arrivals of fixed-size packets spread uniformly over a
+ * number of flows, for runs without a captured trace.
+ */
+class PoissonPacketTrace : public PacketTrace
+{
+public:
+  /**
+   * \param rate the mean arrival rate in packets/s
+   * \param size the packet size in bytes
+   * \param flows the number of flows
+   * \param duration the trace duration in s
+   * \param seed the random seed
+   */
+  PoissonPacketTrace (double rate, uint32_t size, uint32_t flows, double duration, uint32_t seed);
+
+  virtual bool Next (TracePacket& packet);
+
+private:
+  std::mt19937_64 m_rng;
+  std::exponential_distribution<double> m_gap;
+  std::uniform_int_distribution<uint32_t> m_flow;
+  uint32_t m_size;
+  double m_duration;
+  double m_now;
+};
+
+/**
+ * \ingroup NS3Socket
+ * \param fileName a pcap or binary trace
+ * \return the trace, or nullptr if it cannot be opened
+ */
+std::unique_ptr<PacketTrace> OpenPacketTrace (const std::string& fileName);
+
+}
+
+#endif /* PACKET_TRACE_H */
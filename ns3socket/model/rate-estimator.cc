@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "rate-estimator.h"
+
+#include <cmath>
+
+namespace ns3
+{
+
+RateEstimator::~RateEstimator ()
+{
+}
+
+ThresholdRateEstimator::ThresholdRateEstimator (uint32_t threshold)
+  : m_threshold (threshold),
+    m_measurement (false),
+    m_start (0),
+    m_count (COUNT_INVALID),
+    m_rate (0)
+{
+}
+
+void
+ThresholdRateEstimator::Seed (double rate)
+{
+  // The threshold estimator has no prior, it always starts from 0
+  (void)rate;
+}
+
+void
+ThresholdRateEstimator::Update (double now, uint32_t bytes, uint32_t backlog)
+{
+  if ((backlog >= m_threshold) && (!m_measurement))
+    {
+      m_start = now;
+      m_count = 0;
+      m_measurement = true;
+    }
+  if (!m_measurement)
+    {
+      return;
+    }
+
+  m_count += bytes;
+  if (m_count >= m_threshold)
+    {
+      double tmp = now - m_start;
+      if (tmp > 0)
+        {
+          if (m_rate == 0)
+            {
+              m_rate = (double)m_count / tmp;
+            }
+          else
+            {
+              // Proportion of old/new processing rate can be changed
+              m_rate = (0.5 * m_rate) + (0.5 * (m_count / tmp));
+            }
+        }
+      // Restart a measurement cycle if number of packets in queue exceeds the threshold
+      m_start = now;
+      m_count = 0;
+      m_measurement = backlog > m_threshold;
+    }
+}
+
+void
+ThresholdRateEstimator::Restart (void)
+{
+  m_count = COUNT_INVALID;
+  m_rate = 0.0;
+}
+
+double
+ThresholdRateEstimator::GetRate (void) const
+{
+  return m_rate;
+}
+
+EwmaRateEstimator::EwmaRateEstimator (double halfLife)
+  : m_halfLife (halfLife > 0 ? halfLife : 1e-3),
+    m_bytes (0),
+    m_last (0),
+    m_pending (0),
+    m_backlogged (false),
+    m_valid (false)
+{
+}
+
+void
+EwmaRateEstimator::Seed (double rate)
+{
+  if (rate > 0)
+    {
+      // Steady-state counter value of a queue served at rate
+      m_bytes = rate * m_halfLife / M_LN2;
+      m_valid = true;
+    }
+}
+
+void
+EwmaRateEstimator::Update (double now, uint32_t bytes, uint32_t backlog)
+{
+  // A packet that waited behind another leaves one service time after it
+  if (m_backlogged)
+    {
+      double dt = now - m_last;
+      if (dt <= 0)
+        {
+          // Several packets left at once, e.g. into a device queue with
+          // room for them: their service time is the next interval
+          m_pending += bytes;
+          m_backlogged = backlog > 0;
+          return;
+        }
+      double served = bytes + m_pending;
+      m_pending = 0;
+      if (m_valid)
+        {
+          // Spread the bytes over the service interval instead of adding
+          // them at its end, which keeps the estimate unbiased
+          double decay = std::exp2 (-dt / m_halfLife);
+          double weight = (1 - decay) * m_halfLife / (dt * M_LN2);
+          m_bytes = m_bytes * decay + served * weight;
+        }
+      else
+        {
+          m_bytes = (served / dt) * m_halfLife / M_LN2;
+          m_valid = true;
+        }
+    }
+  else
+    {
+      m_pending = 0;  // Served before an idle period, not measured
+    }
+  m_last = now;
+  m_backlogged = backlog > 0;
+}
+
+void
+EwmaRateEstimator::Restart (void)
+{
+}
+
+double
+EwmaRateEstimator::GetRate (void) const
+{
+  return m_valid ? m_bytes * M_LN2 / m_halfLife : 0.0;
+}
+
+}
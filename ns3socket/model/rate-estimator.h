@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef RATE_ESTIMATOR_H
+#define RATE_ESTIMATOR_H
+
+#include <cstdint>
+
+namespace ns3
+{
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Estimates the dequeue (service) rate of a queue from the departures.
+ *
+ * Times are in seconds and rates in bytes per second, so the estimators
+ * do not depend on the simulator and can be reused outside ns-3.
+ */
+class RateEstimator
+{
+public:
+  virtual ~RateEstimator ();
+
+  /**
+   * \brief Set a prior rate, e.g. the rate of the attached link
+   * \param rate the rate in bytes/s
+   */
+  virtual void Seed (double rate) = 0;
+  /**
+   * \brief Account one departure
+   * \param now the departure time in s
+   * \param bytes the packet size
+   * \param backlog the bytes left in the queue after the departure
+   */
+  virtual void Update (double now, uint32_t bytes, uint32_t backlog) = 0;
+  /**
+   * \brief Restart the measurement after a quiet period. Estimators
+   *        that track the rate continuously may ignore it.
+   */
+  virtual void Restart (void) = 0;
+  /**
+   * \return the estimated rate in bytes/s, 0 if unknown
+   */
+  virtual double GetRate (void) const = 0;
+};
+
+/**
+ * \ingroup NS3Socket
+ *
+ * PIE-style estimator: measures the time to dequeue threshold bytes once
+ * the backlog reaches the threshold, and averages it 50/50 with the
+ * previous rate. It stays at 0 until the first measurement completes.
+ */
+class ThresholdRateEstimator : public RateEstimator
+{
+public:
+  /**
+   * \param threshold the minimum backlog in bytes before a measurement starts
+   */
+  ThresholdRateEstimator (uint32_t threshold);
+
+  virtual void Seed (double rate);
+  virtual void Update (double now, uint32_t bytes, uint32_t backlog);
+  virtual void Restart (void);
+  virtual double GetRate (void) const;
+
+private:
+  static const uint64_t COUNT_INVALID = UINT64_MAX;	// invalid packet count value
+
+  uint32_t m_threshold;
+  bool m_measurement;
+  double m_start;
+  uint64_t m_count;
+  double m_rate;
+};
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Exponentially decaying byte counter over backlogged time.
+ *
+ * Only departures of packets that found a backlog measure the service
+ * rate, so idle periods neither decay the estimate nor count as slow
+ * service. The counter decays with the configured half-life, which bounds
+ * how long the estimate takes to follow a rate change. Each update is O(1).
+ * Until the first measurement the seed rate, if any, is reported.
+ */
+class EwmaRateEstimator : public RateEstimator
+{
+public:
+  /**
+   * \param halfLife the half-life of the byte counter in s
+   */
+  EwmaRateEstimator (double halfLife);
+
+  virtual void Seed (double rate);
+  virtual void Update (double now, uint32_t bytes, uint32_t backlog);
+  virtual void Restart (void);
+  virtual double GetRate (void) const;
+
+private:
+  double m_halfLife;
+  double m_bytes;       // Decayed byte counter
+  double m_last;        // Time of the previous departure
+  uint64_t m_pending;   // Bytes that left at the time of the previous departure
+  bool m_backlogged;    // True if the queue was not empty after the previous departure
+  bool m_valid;         // True once m_bytes holds a seed or a measurement
+};
+
+}
+
+#endif /* RATE_ESTIMATOR_H */
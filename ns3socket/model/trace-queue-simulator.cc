@@ -0,0 +1,390 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "trace-queue-simulator.h"
+#include "ns3socket.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+namespace ns3
+{
+
+namespace
+{
+
+const uint64_t NEVER = std::numeric_limits<uint64_t>::max ();
+const uint64_t SAMPLE_PERIOD = 100000000;  // Buffer size sampling, as track_queue_length
+
+}
+
+TraceQueueSimulator::TraceQueueSimulator ()
+  : m_rateIndex (0),
+    m_bufferSize (50),
+    m_updatePeriod (10000000),
+    m_estimator (new EwmaRateEstimator (0.01)),
+    m_seedEstimator (true),
+    m_flowTableSize (0),
+    m_policy (STUB),
+    m_client (nullptr),
+    m_fallbackPolicy (STUB),
+    m_fallbackAction (1),
+    m_stats (nullptr)
+{
+  m_rates.push_back (std::make_pair (0, 10e6));
+}
+
+void
+TraceQueueSimulator::SetServiceRate (double rate)
+{
+  m_rates.front ().second = rate;
+}
+
+void
+TraceQueueSimulator::AddRateChange (double time, double rate)
+{
+  std::pair<uint64_t, double> change ((uint64_t)(time * 1e9), rate);
+  auto it = std::upper_bound (m_rates.begin (), m_rates.end (), change,
+                              [] (const std::pair<uint64_t, double>& a, const std::pair<uint64_t, double>& b)
+                              { return a.first < b.first; });
+  m_rates.insert (it, change);
+}
+
+bool
+TraceQueueSimulator::LoadRateSchedule (const std::string& fileName)
+{
+  std::ifstream in (fileName);
+  if (!in)
+    {
+      return false;
+    }
+  double time, rate;
+  while (in >> time >> rate)
+    {
+      if (time <= 0)
+        {
+          SetServiceRate (rate);
+        }
+      else
+        {
+          AddRateChange (time, rate);
+        }
+    }
+  return in.eof ();
+}
+
+void
+TraceQueueSimulator::SetBufferSize (uint32_t packets)
+{
+  m_bufferSize = packets;
+}
+
+void
+TraceQueueSimulator::SetUpdatePeriod (double period)
+{
+  m_updatePeriod = (uint64_t)(period * 1e9);
+}
+
+void
+TraceQueueSimulator::SetRateEstimator (std::unique_ptr<RateEstimator> estimator, bool seed)
+{
+  m_estimator = std::move (estimator);
+  m_seedEstimator = seed;
+}
+
+void
+TraceQueueSimulator::SetFlowTable (uint32_t capacity, double ageTimeout)
+{
+  m_flowTableSize = capacity;
+  m_flowTable.SetCapacity (capacity);
+  m_flowTable.SetAgeTimeout ((uint64_t)(ageTimeout * 1e9));
+}
+
+void
+TraceQueueSimulator::SetPolicy (Policy policy, NS3Client* client)
+{
+  m_policy = policy;
+  m_client = client;
+}
+
+void
+TraceQueueSimulator::SetFallback (Policy policy, action_t action)
+{
+  m_fallbackPolicy = policy;
+  m_fallbackAction = action;
+}
+
+void
+TraceQueueSimulator::SetStats (DecisionStats* stats)
+{
+  m_stats = stats;
+}
+
+BufferController&
+TraceQueueSimulator::GetController (void)
+{
+  return m_controller;
+}
+
+double
+TraceQueueSimulator::GetServiceRate (void)
+{
+  while (m_rateIndex + 1 < m_rates.size () && m_rates[m_rateIndex + 1].first <= m_now)
+    {
+      m_rateIndex++;
+    }
+  return m_rates[m_rateIndex].second;
+}
+
+void
+TraceQueueSimulator::Run (PacketTrace& trace, double duration)
+{
+  m_now = 0;
+  m_rateIndex = 0;
+  m_queue.clear ();
+  m_bytes = 0;
+  m_busy = false;
+  m_txEnd = 0;
+  m_nextControl = 0;
+  m_rewardPending = false;
+  m_lastDecisionEnd = 0;
+  m_arrivals = 0;
+  m_departures = 0;
+  m_drops = 0;
+  m_marks = 0;
+  m_fallbacks = 0;
+  m_bufferSizeSum = 0;
+  m_bufferSamples = 0;
+  m_controller.Reset (m_bufferSize);
+  if (m_seedEstimator)
+    {
+      m_estimator->Seed (GetServiceRate () / 8.0);
+    }
+
+  uint64_t end = duration > 0 ? (uint64_t)(duration * 1e9) : NEVER;
+  uint64_t nextSample = SAMPLE_PERIOD;
+  TracePacket packet;
+  bool more = trace.Next (packet);
+  while (true)
+    {
+      if (!more && !m_busy && duration <= 0)
+        {
+          break;  // Trace replayed and queue drained
+        }
+      uint64_t next = std::min (std::min (more ? packet.time : NEVER, m_busy ? m_txEnd : NEVER),
+                                std::min (m_nextControl, nextSample));
+      if (next == NEVER || next > end)
+        {
+          break;
+        }
+      m_now = next;
+
+      // Ties: transmissions end before arrivals, which come before decisions
+      if (m_busy && m_txEnd == m_now)
+        {
+          m_busy = false;
+          StartTransmission ();
+        }
+      else if (more && packet.time == m_now)
+        {
+          Arrive (packet);
+          more = trace.Next (packet);
+          packet.time = std::max (packet.time, m_now);  // Out-of-order records arrive now
+        }
+      else if (m_nextControl == m_now)
+        {
+          Control ();
+        }
+      else
+        {
+          m_bufferSizeSum += m_bufferSize;
+          m_bufferSamples++;
+          nextSample += SAMPLE_PERIOD;
+        }
+    }
+  if (end != NEVER)
+    {
+      m_now = end;
+    }
+}
+
+void
+TraceQueueSimulator::Arrive (const TracePacket& packet)
+{
+  m_arrivals++;
+  if (m_queue.size () + 1 > m_bufferSize)
+    {
+      m_drops++;
+      m_controller.NotifyArrival (false);
+      if (m_flowTableSize > 0)
+        {
+          m_flowTable.NotifyDrop (packet.hash, m_now);
+        }
+      return;
+    }
+  if (m_controller.ShouldMark (m_queue.size ()))
+    {
+      // The trace carries no ECN codepoint, every packet is treated as ECT
+      m_marks++;
+      m_controller.NotifyMark ();
+    }
+  m_queue.push_back (Queued {packet.size, packet.hash});
+  m_bytes += packet.size;
+  m_controller.NotifyArrival (true);
+  if (m_flowTableSize > 0)
+    {
+      m_flowTable.NotifyEnqueue (packet.hash, m_now);
+    }
+  if (!m_busy)
+    {
+      StartTransmission ();
+    }
+}
+
+void
+TraceQueueSimulator::StartTransmission (void)
+{
+  if (m_queue.empty ())
+    {
+      return;
+    }
+  Queued item = m_queue.front ();
+  m_queue.pop_front ();
+  m_bytes -= item.size;
+  m_departures++;
+  if (m_flowTableSize > 0)
+    {
+      m_flowTable.NotifyDequeue (item.hash, item.size, m_now);
+    }
+  m_estimator->Update (m_now * 1e-9, item.size, m_bytes);
+
+  double rate = GetServiceRate ();
+  m_txEnd = m_now + (uint64_t)(item.size * 8e9 / (rate > 0 ? rate : 1.0));
+  m_busy = true;
+}
+
+void
+TraceQueueSimulator::Control (void)
+{
+  if (m_rewardPending)
+    {
+      m_controller.CalculateReward (m_queue.size (), m_bytes, m_bufferSize, *m_estimator);
+      m_rewardPending = false;
+    }
+  if (!m_queue.empty ())
+    {
+      SelectAction ();
+      m_rewardPending = true;
+    }
+  else if (m_flowTableSize > 0)
+    {
+      m_flowTable.NewSlot ();  // No decision, the flow slot ends all the same
+    }
+  m_nextControl = m_now + m_updatePeriod;
+}
+
+void
+TraceQueueSimulator::SelectAction (void)
+{
+  uint64_t decisionStart = 0;
+  if (m_stats)
+    {
+      decisionStart = DecisionStats::Now ();
+      if (m_lastDecisionEnd > 0)
+        {
+          m_stats->Record (STAGE_SIMULATE, m_lastDecisionEnd, decisionStart);
+        }
+    }
+
+  observation_t ob = m_controller.GetObservation (m_queue.size (), m_bytes, m_bufferSize, m_estimator->GetRate (),
+                                                  m_flowTableSize > 0 ? &m_flowTable : nullptr);
+  action_t action = 1;
+  if (m_policy == AGENT && m_client)
+    {
+      DRLstate state = {(float)ob[0], (float)ob[1], (float)ob[2], (float)ob[3],
+                        m_controller.GetLastReward (), false, std::vector<float> (ob.begin () + 4, ob.end ())};
+      float reply = -1;
+      bool sent = m_client->SendData (&state);
+      bool received = m_client->RecvData (reply);  //Even if not sent, so that every stage is timed
+      if (sent && received && reply >= 0 && reply <= 2)
+        {
+          action = (action_t)reply;
+        }
+      else
+        {
+          m_fallbacks++;
+          action = m_fallbackPolicy == NATIVE ? m_controller.NativeAction (ob) : m_fallbackAction;
+        }
+    }
+  else if (m_policy == NATIVE)
+    {
+      action = m_controller.NativeAction (ob);
+    }
+
+  m_bufferSize = m_controller.ApplyAction (action, m_bufferSize, m_queue.size ());
+  if (m_flowTableSize > 0)
+    {
+      m_flowTable.NewSlot ();
+    }
+  if (m_stats)
+    {
+      m_lastDecisionEnd = DecisionStats::Now ();
+      m_stats->Record (STAGE_DECISION, decisionStart, m_lastDecisionEnd);
+    }
+}
+
+double
+TraceQueueSimulator::GetTime (void) const
+{
+  return m_now * 1e-9;
+}
+
+uint64_t
+TraceQueueSimulator::GetArrivals (void) const
+{
+  return m_arrivals;
+}
+
+uint64_t
+TraceQueueSimulator::GetDepartures (void) const
+{
+  return m_departures;
+}
+
+uint64_t
+TraceQueueSimulator::GetDrops (void) const
+{
+  return m_drops;
+}
+
+uint64_t
+TraceQueueSimulator::GetMarks (void) const
+{
+  return m_marks;
+}
+
+uint64_t
+TraceQueueSimulator::GetFallbacks (void) const
+{
+  return m_fallbacks;
+}
+
+uint32_t
+TraceQueueSimulator::GetBufferSize (void) const
+{
+  return m_bufferSize;
+}
+
+double
+TraceQueueSimulator::GetAverageBufferSize (void) const
+{
+  return m_bufferSamples > 0 ? m_bufferSizeSum / m_bufferSamples : m_bufferSize;
+}
+
+const FlowTable&
+TraceQueueSimulator::GetFlowTable (void) const
+{
+  return m_flowTable;
+}
+
+}
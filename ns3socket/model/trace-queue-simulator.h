@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef TRACE_QUEUE_SIMULATOR_H
+#define TRACE_QUEUE_SIMULATOR_H
+
+#include "buffer-controller.h"
+#include "decision-stats.h"
+#include "flow-table.h"
+#include "packet-trace.h"
+#include "rate-estimator.h"
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+class NS3Client;
+
+/**
+ * \ingroup NS3Socket
+ *
+ * Standalone trace-driven model of a DuelingDQNFifoQueueDisc bottleneck.
+ *
+ * Packets of a PacketTrace arrive at a FIFO queue served by a single link,
+ * whose rate is constant or follows a piecewise-constant schedule. A packet
+ * leaves the queue when its transmission starts, like a queue disc in front
+ * of a device that holds one packet. The buffer size is controlled by the
+ * same BufferController, RateEstimator and FlowTable as the queue disc, on
+ * the same slot timing, and the decisions come from the agent over
+ * NS3Client, the embedded heuristic or a stub.
+ *
+ * There is no closed loop: the arrivals do not react to drops, marks or
+ * delay. In exchange a run needs no ns-3 node, device or TCP stack and only
+ * costs a few operations per packet.
+ */
+class TraceQueueSimulator
+{
+public:
+  /**
+   * \brief Where the buffer sizing decisions come from, as in DuelingDQNFifoQueueDisc
+   */
+  enum Policy
+  {
+    AGENT,  //!< Remote RL agent over NS3Client
+    STUB,   //!< Always keep the buffer size
+    NATIVE  //!< Embedded delay/drop heuristic
+  };
+
+  TraceQueueSimulator ();
+
+  /**
+   * \param rate the link rate in bits/s from time 0
+   */
+  void SetServiceRate (double rate);
+  /**
+   * \brief Change the link rate from the given time on
+   * \param time the time of the change in s
+   * \param rate the new link rate in bits/s
+   */
+  void AddRateChange (double time, double rate);
+  /**
+   * \param fileName a text file of "time_s rate_bps" lines
+   * \return false if the file cannot be read
+   */
+  bool LoadRateSchedule (const std::string& fileName);
+  /**
+   * \param packets the initial buffer size in packets
+   */
+  void SetBufferSize (uint32_t packets);
+  /**
+   * \param period the slot time in s
+   */
+  void SetUpdatePeriod (double period);
+  /**
+   * \param estimator the dequeue rate estimator
+   * \param seed true to seed it with the initial link rate
+   */
+  void SetRateEstimator (std::unique_ptr<RateEstimator> estimator, bool seed);
+  /**
+   * \param capacity the flow table entries, 0 to disable it
+   * \param ageTimeout the idle time in s after which an entry may be reused
+   */
+  void SetFlowTable (uint32_t capacity, double ageTimeout);
+  /**
+   * \param policy the decision policy
+   * \param client the agent connection for the AGENT policy, owned by the caller
+   */
+  void SetPolicy (Policy policy, NS3Client* client);
+  /**
+   * \param policy STUB or NATIVE, applied when the agent gives no valid action
+   * \param action the action of the STUB fallback
+   */
+  void SetFallback (Policy policy, action_t action);
+  /**
+   * \param stats the decision stage counters, nullptr to disable instrumentation
+   */
+  void SetStats (DecisionStats* stats);
+  /**
+   * \return the controller, to configure the delay target, ECN and size limits
+   */
+  BufferController& GetController (void);
+
+  /**
+   * \brief Replay a trace
+   * \param trace the arrivals
+   * \param duration the simulated time in s, 0 to run until the trace ends
+   *        and the queue drains
+   */
+  void Run (PacketTrace& trace, double duration);
+
+  double GetTime (void) const;          //!< Simulated time in s
+  uint64_t GetArrivals (void) const;
+  uint64_t GetDepartures (void) const;
+  uint64_t GetDrops (void) const;
+  uint64_t GetMarks (void) const;
+  uint64_t GetFallbacks (void) const;
+  uint32_t GetBufferSize (void) const;
+  double GetAverageBufferSize (void) const;  //!< Buffer size sampled every 100 ms
+  const FlowTable& GetFlowTable (void) const;
+
+private:
+  struct Queued
+  {
+    uint32_t size;
+    uint32_t hash;
+  };
+
+  void Arrive (const TracePacket& packet);
+  void StartTransmission (void);
+  void Control (void);
+  void SelectAction (void);
+  double GetServiceRate (void);
+
+  std::vector<std::pair<uint64_t, double> > m_rates;  // Sorted (time ns, bits/s) schedule
+  size_t m_rateIndex;
+  uint32_t m_bufferSize;
+  uint64_t m_updatePeriod;    // ns
+  std::unique_ptr<RateEstimator> m_estimator;
+  bool m_seedEstimator;
+  uint32_t m_flowTableSize;
+  FlowTable m_flowTable;
+  Policy m_policy;
+  NS3Client* m_client;
+  Policy m_fallbackPolicy;
+  action_t m_fallbackAction;
+  DecisionStats* m_stats;
+  BufferController m_controller;
+
+  uint64_t m_now;             // ns
+  std::deque<Queued> m_queue;
+  uint64_t m_bytes;           // Backlog in bytes
+  bool m_busy;
+  uint64_t m_txEnd;
+  uint64_t m_nextControl;
+  bool m_rewardPending;       // An action waits for its reward
+  uint64_t m_lastDecisionEnd;
+
+  uint64_t m_arrivals;
+  uint64_t m_departures;
+  uint64_t m_drops;
+  uint64_t m_marks;
+  uint64_t m_fallbacks;
+  double m_bufferSizeSum;
+  uint64_t m_bufferSamples;
+};
+
+}
+
+#endif /* TRACE_QUEUE_SIMULATOR_H */
@@ -2,6 +2,10 @@
 
 // Include a header file from your module to test.
 #include "ns3/ns3socket.h"
+#include "ns3/flow-table.h"
+#include "ns3/rate-estimator.h"
+#include "ns3/trace-queue-simulator.h"
+#include "ns3/buffer-control-core.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -46,6 +50,739 @@ Ns3socketTestCase1::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+// Check the per-stage counters and histogram quantiles of DecisionStats
+class DecisionStatsTestCase : public TestCase
+{
+public:
+  DecisionStatsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DecisionStatsTestCase::DecisionStatsTestCase ()
+  : TestCase ("Check DecisionStats counters and histogram")
+{
+}
+
+void
+DecisionStatsTestCase::DoRun (void)
+{
+  DecisionStats stats;
+  for (uint64_t i = 0; i < 99; i++)
+    {
+      stats.Record (STAGE_AGENT, 1000, 1000 + 100);
+    }
+  stats.Record (STAGE_AGENT, 1000, 1000 + 100000);
+
+  NS_TEST_ASSERT_MSG_EQ (stats.GetCount (STAGE_AGENT), 100, "Wrong number of recorded intervals");
+  NS_TEST_ASSERT_MSG_EQ (stats.GetTotal (STAGE_AGENT), 99 * 100 + 100000, "Wrong total duration");
+  NS_TEST_ASSERT_MSG_EQ (stats.GetMax (STAGE_AGENT), 100000, "Wrong maximum duration");
+  NS_TEST_ASSERT_MSG_EQ (stats.GetLast (STAGE_AGENT), 100000, "Wrong last duration");
+  // 100 ns falls in the [64, 128) bucket, quantiles are capped by the maximum
+  NS_TEST_ASSERT_MSG_EQ (stats.GetQuantile (STAGE_AGENT, 0.5), 127, "Wrong median bucket");
+  NS_TEST_ASSERT_MSG_EQ (stats.GetQuantile (STAGE_AGENT, 1.0), 100000, "Wrong maximum quantile");
+  NS_TEST_ASSERT_MSG_EQ (stats.GetCount (STAGE_SEND), 0, "Unrelated stage was updated");
+
+  stats.ClearLast ();
+  NS_TEST_ASSERT_MSG_EQ (stats.GetLast (STAGE_AGENT), 0, "Last duration not cleared");
+  NS_TEST_ASSERT_MSG_EQ (stats.GetCount (STAGE_AGENT), 100, "Counters cleared with the last duration");
+
+  // A decision that skips a stage reports it as 0, not as the previous one
+  DecisionInstrumentation instrumentation;
+  instrumentation.GetStats ()->Record (STAGE_PARSE, 0, 500);
+  instrumentation.End (instrumentation.Start ());
+  NS_TEST_ASSERT_MSG_EQ (instrumentation.GetStats ()->GetLast (STAGE_PARSE), 0, "Stale stage of an earlier decision");
+  NS_TEST_ASSERT_MSG_EQ (instrumentation.GetStats ()->GetCount (STAGE_DECISION), 1, "Decision not recorded");
+
+  stats.Reset ();
+  NS_TEST_ASSERT_MSG_EQ (stats.GetCount (STAGE_AGENT), 0, "Counters not cleared by Reset");
+}
+
+// Check flow accounting, aging and the fairness index of FlowTable
+class FlowTableTestCase : public TestCase
+{
+public:
+  FlowTableTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FlowTableTestCase::FlowTableTestCase ()
+  : TestCase ("Check FlowTable accounting and eviction")
+{
+}
+
+void
+FlowTableTestCase::DoRun (void)
+{
+  FlowTable table;
+  table.SetCapacity (5);
+  table.SetAgeTimeout (100);
+  NS_TEST_ASSERT_MSG_EQ (table.GetCapacity (), 8, "Capacity not rounded up to a power of two");
+
+  table.NotifyDequeue (1, 1000, 0);
+  table.NotifyDequeue (2, 1000, 0);
+  NS_TEST_ASSERT_MSG_EQ (table.GetActiveFlows (), 2, "Wrong number of active flows");
+  NS_TEST_ASSERT_MSG_EQ_TOL (table.GetJainIndex (), 1.0, 1e-9, "Equal shares are not fair");
+
+  // A third flow that only gets drops is starved
+  table.NotifyDrop (3, 0);
+  NS_TEST_ASSERT_MSG_EQ (table.GetActiveFlows (), 3, "Dropping flow not counted as active");
+  NS_TEST_ASSERT_MSG_EQ_TOL (table.GetJainIndex (), 2.0 / 3.0, 1e-9, "Wrong fairness index");
+  NS_TEST_ASSERT_MSG_EQ (table.Find (3)->drops, 1, "Drop not accounted");
+  NS_TEST_ASSERT_MSG_EQ (table.Find (1)->bytes, 1000, "Bytes not accounted");
+
+  table.NewSlot ();
+  NS_TEST_ASSERT_MSG_EQ (table.GetActiveFlows (), 0, "Slot counters not cleared");
+  NS_TEST_ASSERT_MSG_EQ (table.Find (1)->bytes, 1000, "Flow totals cleared by a new slot");
+
+  // Fill every entry, then a new flow only fits once an entry has aged
+  for (uint32_t h = 0; h < 8; h++)
+    {
+      table.NotifyEnqueue (h, 10);
+    }
+  table.NotifyEnqueue (8, 50);
+  NS_TEST_ASSERT_MSG_EQ (table.GetOverflows (), 1, "Full table did not overflow");
+  table.NotifyEnqueue (8, 200);
+  NS_TEST_ASSERT_MSG_EQ (table.GetEvictions (), 1, "Aged flow not evicted");
+  NS_TEST_ASSERT_MSG_EQ ((table.Find (8) != nullptr), true, "New flow not inserted");
+}
+
+// Check that EwmaRateEstimator starts from the seed, is unbiased and
+// follows a rate change within a few half-lives
+class RateEstimatorTestCase : public TestCase
+{
+public:
+  RateEstimatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+RateEstimatorTestCase::RateEstimatorTestCase ()
+  : TestCase ("Check the EWMA and threshold dequeue rate estimators")
+{
+}
+
+void
+RateEstimatorTestCase::DoRun (void)
+{
+  // 1250 byte packets served back to back at 10 Mbps, i.e. one every 1 ms
+  EwmaRateEstimator ewma (0.01);
+  NS_TEST_ASSERT_MSG_EQ (ewma.GetRate (), 0, "Unseeded estimator reports a rate");
+  ewma.Seed (1.25e6);
+  NS_TEST_ASSERT_MSG_EQ_TOL (ewma.GetRate (), 1.25e6, 1, "Seed not reported before any departure");
+
+  double now = 0;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      now += 0.001;
+      ewma.Update (now, 1250, 5000);
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (ewma.GetRate (), 1.25e6, 1, "Biased steady-state estimate");
+
+  // Halve the service rate, four half-lives later the estimate is within 10%
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      now += 0.002;
+      ewma.Update (now, 1250, 5000);
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (ewma.GetRate (), 6.25e5, 6.25e4, "Rate change not followed");
+
+  // The queue drains, the packet after the idle period is not slow service
+  ewma.Update (now + 0.002, 1250, 0);
+  double before = ewma.GetRate ();
+  ewma.Update (now + 1.0, 1250, 0);
+  NS_TEST_ASSERT_MSG_EQ_TOL (ewma.GetRate (), before, 1, "Idle time decayed the estimate");
+
+  // Pairs of packets leaving at the same time every 2 ms are still 10 Mbps
+  EwmaRateEstimator pairs (0.01);
+  pairs.Seed (1.25e6);
+  now = 0;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      now += 0.002;
+      pairs.Update (now, 1250, 5000);
+      pairs.Update (now, 1250, 5000);
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (pairs.GetRate (), 1.25e6, 1.25e4, "Same-time departures inflate the estimate");
+
+  // TraceQueueSimulator seeds with the link rate, as SeedFromDevice does in
+  // the queue disc, and a single packet into an empty queue measures nothing
+  for (bool seed : {true, false})
+    {
+      EwmaRateEstimator* estimator = new EwmaRateEstimator (0.01);
+      TraceQueueSimulator sim;
+      sim.SetServiceRate (8e6);
+      sim.SetRateEstimator (std::unique_ptr<RateEstimator> (estimator), seed);
+      PoissonPacketTrace single (1, 1250, 1, 1.0, 1);
+      sim.Run (single, 0);
+      NS_TEST_ASSERT_MSG_EQ_TOL (estimator->GetRate (), seed ? 1e6 : 0, 1, "Wrong seeding from the link rate");
+    }
+
+  // The threshold estimator needs a backlog of threshold bytes before it measures
+  ThresholdRateEstimator threshold (2000);
+  threshold.Seed (1.25e6);
+  threshold.Update (0.001, 1250, 1000);
+  NS_TEST_ASSERT_MSG_EQ (threshold.GetRate (), 0, "Threshold estimator measured below the threshold");
+  now = 0.001;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      now += 0.001;
+      threshold.Update (now, 1250, 5000);
+    }
+  NS_TEST_ASSERT_MSG_EQ ((threshold.GetRate () > 0), true, "Threshold estimator did not measure");
+}
+
+// Check that NS3Client gives up on a silent agent within the deadline and
+// falls back instead of blocking
+class ClientDeadlineTestCase : public TestCase
+{
+public:
+  ClientDeadlineTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ClientDeadlineTestCase::ClientDeadlineTestCase ()
+  : TestCase ("Check NS3Client decision deadline")
+{
+}
+
+void
+ClientDeadlineTestCase::DoRun (void)
+{
+  // A listening socket that never answers stands in for a hung agent
+  int listener = socket (AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr;
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = inet_addr ("127.0.0.1");
+  addr.sin_port = 0;
+  socklen_t len = sizeof (addr);
+  NS_TEST_ASSERT_MSG_EQ (bind (listener, (sockaddr*)&addr, sizeof (addr)), 0, "Cannot bind the agent socket");
+  NS_TEST_ASSERT_MSG_EQ (listen (listener, 1), 0, "Cannot listen on the agent socket");
+  getsockname (listener, (sockaddr*)&addr, &len);
+
+  NS3Client client ("127.0.0.1", ntohs (addr.sin_port));
+  DecisionStats stats;
+  client.SetStats (&stats);
+  client.SetDeadline (20000000);
+  DRLstate state = {1, 2, 3, 4, 0, false, {}};
+  float action = -1;
+
+  uint64_t start = DecisionStats::Now ();
+  NS_TEST_ASSERT_MSG_EQ (client.SendData (&state), true, "State not sent");
+  NS_TEST_ASSERT_MSG_EQ (client.RecvData (action), false, "Silent agent returned an action");
+  uint64_t elapsed = DecisionStats::Now () - start;
+  NS_TEST_ASSERT_MSG_EQ (client.GetMissedDeadlines (), 1, "Missed deadline not counted");
+  NS_TEST_ASSERT_MSG_LT (elapsed, 1000000000, "Decision blocked far beyond its deadline");
+  NS_TEST_ASSERT_MSG_EQ (stats.GetCount (STAGE_AGENT), 1, "Missed deadline not timed");
+  NS_TEST_ASSERT_MSG_GT (stats.GetLast (STAGE_AGENT), 10000000, "Wait for the silent agent not timed");
+
+  // The agent is still busy with the first state, the next one is not sent
+  // and there is no reply to wait for, both stages are still timed
+  NS_TEST_ASSERT_MSG_EQ (client.SendData (&state), false, "State sent while a reply is pending");
+  NS_TEST_ASSERT_MSG_EQ (client.RecvData (action), false, "Action returned while a reply is pending");
+  NS_TEST_ASSERT_MSG_EQ (stats.GetCount (STAGE_SEND), 2, "Skipped send not timed");
+  NS_TEST_ASSERT_MSG_EQ (stats.GetCount (STAGE_AGENT), 2, "Skipped wait not timed");
+  NS_TEST_ASSERT_MSG_EQ (stats.GetCount (STAGE_SERIALIZE), 1, "Skipped state serialized");
+
+  client.CloseClient ();
+  close (listener);
+}
+
+// Check that a late reply prefixed with a snapshot request is dropped
+// whole, and that the request itself is kept
+class ClientLateSnapshotTestCase : public TestCase
+{
+public:
+  ClientLateSnapshotTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ClientLateSnapshotTestCase::ClientLateSnapshotTestCase ()
+  : TestCase ("Check NS3Client drop of a late snapshot-prefixed reply")
+{
+}
+
+void
+ClientLateSnapshotTestCase::DoRun (void)
+{
+  int listener = socket (AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr;
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = inet_addr ("127.0.0.1");
+  addr.sin_port = 0;
+  socklen_t len = sizeof (addr);
+  NS_TEST_ASSERT_MSG_EQ (bind (listener, (sockaddr*)&addr, sizeof (addr)), 0, "Cannot bind the agent socket");
+  NS_TEST_ASSERT_MSG_EQ (listen (listener, 1), 0, "Cannot listen on the agent socket");
+  getsockname (listener, (sockaddr*)&addr, &len);
+
+  NS3Client client ("127.0.0.1", ntohs (addr.sin_port));
+  client.SetDeadline (20000000);
+  DRLstate state = {1, 2, 3, 4, 0, false, {}};
+  float action = -1;
+  NS_TEST_ASSERT_MSG_EQ (client.SendData (&state), true, "State not sent");
+  NS_TEST_ASSERT_MSG_EQ (client.RecvData (action), false, "Silent agent returned an action");
+  int agent = accept (listener, nullptr, nullptr);
+  NS_TEST_ASSERT_MSG_EQ ((agent >= 0), true, "Cannot accept the client");
+
+  // The snapshot request arrives first, the stale action is not there yet
+  send (agent, "snapshot", 9, 0);
+  usleep (20000);
+  NS_TEST_ASSERT_MSG_EQ (client.SendData (&state), false, "State sent before the late action was read");
+  NS_TEST_ASSERT_MSG_EQ (client.TakeSnapshotRequest (), true, "Late snapshot request lost");
+
+  send (agent, "2", 2, 0);
+  usleep (20000);
+  NS_TEST_ASSERT_MSG_EQ (client.SendData (&state), true, "State not sent after the late reply");
+
+  // Both parts of a late reply in one go
+  NS_TEST_ASSERT_MSG_EQ (client.RecvData (action), false, "Silent agent returned an action");
+  send (agent, "snapshot\0" "2", 11, 0);
+  usleep (20000);
+  NS_TEST_ASSERT_MSG_EQ (client.SendData (&state), true, "State not sent after the late reply");
+  NS_TEST_ASSERT_MSG_EQ (client.TakeSnapshotRequest (), true, "Late snapshot request lost");
+
+  // The reply to the new state is the one returned
+  send (agent, "0", 2, 0);
+  NS_TEST_ASSERT_MSG_EQ (client.RecvData (action), true, "Reply to the new state not received");
+  NS_TEST_ASSERT_MSG_EQ (action, 0, "Stale action returned for the new state");
+
+  client.CloseClient ();
+  close (agent);
+  close (listener);
+}
+
+// Check the replay of a binary trace and the buffer control of the
+// standalone trace-driven simulator
+class TraceQueueSimulatorTestCase : public TestCase
+{
+public:
+  TraceQueueSimulatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TraceQueueSimulatorTestCase::TraceQueueSimulatorTestCase ()
+  : TestCase ("Check the trace-driven queue simulator")
+{
+}
+
+void
+TraceQueueSimulatorTestCase::DoRun (void)
+{
+  // 1250 byte packets every 2 ms, half of the 10 Mbps link
+  std::string fileName = CreateTempDirFilename ("trace-queue-sim.bin");
+  FILE* f = std::fopen (fileName.c_str (), "wb");
+  NS_TEST_ASSERT_MSG_EQ (f != nullptr, true, "Cannot create the binary trace");
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      TracePacket packet = {5000000000ULL + i * 2000000ULL, 1250, i % 4};
+      BinaryPacketTrace::Write (f, packet);
+    }
+  std::fclose (f);
+
+  std::unique_ptr<PacketTrace> trace = OpenPacketTrace (fileName);
+  NS_TEST_ASSERT_MSG_EQ (trace != nullptr, true, "Cannot open the binary trace");
+  TraceQueueSimulator underload;
+  underload.SetServiceRate (10e6);
+  underload.SetFlowTable (16, 1.0);
+  underload.Run (*trace, 0);
+  NS_TEST_ASSERT_MSG_EQ (underload.GetArrivals (), 1000, "Trace not replayed");
+  NS_TEST_ASSERT_MSG_EQ (underload.GetDepartures (), 1000, "Queue not drained");
+  NS_TEST_ASSERT_MSG_EQ (underload.GetDrops (), 0, "Drops below the link rate");
+  NS_TEST_ASSERT_MSG_EQ_TOL (underload.GetTime (), 1.999, 0.001, "Times not rebased on the first record");
+  NS_TEST_ASSERT_MSG_EQ (underload.GetFlowTable ().Find (3)->bytes, 250 * 1250, "Flow bytes not accounted");
+
+  // Twice the link rate, the stub keeps the buffer size
+  PoissonPacketTrace overloadTrace (2000, 1250, 4, 2.0, 1);
+  TraceQueueSimulator stub;
+  stub.SetServiceRate (10e6);
+  stub.SetBufferSize (20);
+  stub.Run (overloadTrace, 2.0);
+  NS_TEST_ASSERT_MSG_GT (stub.GetDrops (), 0, "No drops above the link rate");
+  NS_TEST_ASSERT_MSG_EQ (stub.GetBufferSize (), 20, "Stub policy changed the buffer size");
+  NS_TEST_ASSERT_MSG_GT (stub.GetController ().GetDecisionCount (), 100, "Too few decisions");
+
+  // The heuristic shrinks a buffer whose delay exceeds the target
+  PoissonPacketTrace nativeTrace (2000, 1250, 4, 2.0, 1);
+  TraceQueueSimulator native;
+  native.SetServiceRate (10e6);
+  native.SetBufferSize (20);
+  native.SetPolicy (TraceQueueSimulator::NATIVE, nullptr);
+  native.GetController ().SetDesiredQueueDelay (0.005);
+  native.Run (nativeTrace, 2.0);
+  NS_TEST_ASSERT_MSG_LT (native.GetBufferSize (), 10, "Buffer not reduced to the delay target");
+
+  // Flow slots advance on idle ticks too: a flow that left the queue 100 ms
+  // before the last tick is not active in its slot
+  fileName = CreateTempDirFilename ("idle-slots.bin");
+  f = std::fopen (fileName.c_str (), "wb");
+  NS_TEST_ASSERT_MSG_EQ (f != nullptr, true, "Cannot create the binary trace");
+  TracePacket first = {0, 1250, 1};
+  BinaryPacketTrace::Write (f, first);
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      TracePacket packet = {105000000, 1250, 2};
+      BinaryPacketTrace::Write (f, packet);
+    }
+  std::fclose (f);
+  trace = OpenPacketTrace (fileName);
+  NS_TEST_ASSERT_MSG_EQ (trace != nullptr, true, "Cannot open the binary trace");
+  TraceQueueSimulator idle;
+  idle.SetFlowTable (16, 1.0);
+  idle.Run (*trace, 0.109);
+  NS_TEST_ASSERT_MSG_EQ (idle.GetFlowTable ().GetActiveFlows (), 1, "Idle ticks did not start new flow slots");
+}
+
+// Check that drops at the size limit lower the congestion level, so that a
+// queue that overflows is rewarded on its delay instead of its occupancy
+class BufferControllerCongestionTestCase : public TestCase
+{
+public:
+  BufferControllerCongestionTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param burst the packets arriving at once into a 20 packet buffer
+   * \return the simulator after the reward of the first decision
+   */
+  std::unique_ptr<TraceQueueSimulator> RunBurst (uint32_t burst);
+};
+
+BufferControllerCongestionTestCase::BufferControllerCongestionTestCase ()
+  : TestCase ("Check the congestion level of BufferController")
+{
+}
+
+std::unique_ptr<TraceQueueSimulator>
+BufferControllerCongestionTestCase::RunBurst (uint32_t burst)
+{
+  std::string fileName = CreateTempDirFilename ("congestion.bin");
+  FILE* f = std::fopen (fileName.c_str (), "wb");
+  for (uint32_t i = 0; f && i < burst; i++)
+    {
+      TracePacket packet = {0, 1250, i};
+      BinaryPacketTrace::Write (f, packet);
+    }
+  if (f)
+    {
+      std::fclose (f);
+    }
+  std::unique_ptr<PacketTrace> trace = OpenPacketTrace (fileName);
+  std::unique_ptr<TraceQueueSimulator> sim (new TraceQueueSimulator);
+  if (trace)
+    {
+      // 10 ms per packet, the decision at 0 is rewarded at 10 ms. The delay
+      // reward stays below 0.1, the occupancy reward is about 1
+      sim->SetServiceRate (1e6);
+      sim->SetBufferSize (20);
+      sim->GetController ().SetDesiredQueueDelay (10);
+      sim->Run (*trace, 0.015);
+    }
+  return sim;
+}
+
+void
+BufferControllerCongestionTestCase::DoRun (void)
+{
+  // One packet on the link and 20 queued, every arrival is accepted
+  std::unique_ptr<TraceQueueSimulator> fits = RunBurst (21);
+  NS_TEST_ASSERT_MSG_EQ (fits->GetDrops (), 0, "Burst does not fit the buffer");
+  NS_TEST_ASSERT_MSG_GT (fits->GetController ().GetLastReward (), 0.9, "Accepts not counted as congestion");
+
+  // The next 25 arrivals are dropped and take the level from 5 down to -5
+  std::unique_ptr<TraceQueueSimulator> overflows = RunBurst (46);
+  NS_TEST_ASSERT_MSG_EQ (overflows->GetDrops (), 25, "Burst does not overflow the buffer");
+  NS_TEST_ASSERT_MSG_LT (overflows->GetController ().GetLastReward (), 0.1, "Drops not counted as rejected arrivals");
+
+  // The level saturates at -5: 5 accepts bring it back to 0, a sixth above it
+  BufferController controller;
+  controller.Reset (20);
+  EwmaRateEstimator estimator (0.01);
+  estimator.Seed (1.25e6);
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      controller.NotifyArrival (false);
+    }
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      controller.NotifyArrival (true);
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (controller.CalculateReward (10, 0, 20, estimator), 0, 1e-6, "Level below -5");
+  controller.NotifyArrival (true);
+  NS_TEST_ASSERT_MSG_EQ_TOL (controller.CalculateReward (10, 0, 20, estimator), 0.5, 1e-6,
+                             "Level not back above 0");
+}
+
+// Check the ECN marking decisions of BufferController and BufferControlCore
+class BufferControllerEcnTestCase : public TestCase
+{
+public:
+  BufferControllerEcnTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BufferControllerEcnTestCase::BufferControllerEcnTestCase ()
+  : TestCase ("Check the ECN marking of BufferController")
+{
+}
+
+void
+BufferControllerEcnTestCase::DoRun (void)
+{
+  BufferController controller;
+  controller.SetEcn (true, 0.5, 0.5);
+  controller.Reset (20);
+  NS_TEST_ASSERT_MSG_EQ (controller.ShouldMark (9), false, "Marked below the threshold");
+  NS_TEST_ASSERT_MSG_EQ (controller.ShouldMark (10), true, "Not marked at the threshold");
+
+  // Half of a one packet buffer would be 0, an empty queue must not mark
+  controller.Reset (1);
+  NS_TEST_ASSERT_MSG_EQ (controller.GetMarkThreshold (), 1, "Threshold truncated to 0");
+  NS_TEST_ASSERT_MSG_EQ (controller.ShouldMark (0), false, "Arrival into an empty queue marked");
+
+  BufferControlCore<PacketSizing, EcnSchema> core (EwmaRateEstimator (0.01));
+  core.SetEcn (0.5, 0.5);
+  core.Reset (1);
+  NS_TEST_ASSERT_MSG_EQ (core.ShouldMark (0, 0), false, "Core marked into an empty queue");
+  core.ApplyAction (0, 0, 0);
+  core.ApplyAction (2, 0, 0);
+  NS_TEST_ASSERT_MSG_EQ (core.ShouldMark (0, 0), false, "Core marked into an empty queue after an action");
+
+  // Drops and marks are appended to the observation and cost SignalPenalty
+  // times their share of the arrivals: 10 packets in 20 with 5 signals in 10 arrivals
+  EwmaRateEstimator estimator (0.01);
+  estimator.Seed (1.25e6);
+  for (bool useEcn : {false, true})
+    {
+      controller.SetEcn (useEcn, 0.5, 0.5);
+      controller.Reset (20);
+      for (uint32_t i = 0; i < 10; i++)
+        {
+          controller.NotifyArrival (i < 8);
+        }
+      for (uint32_t i = 0; i < 3; i++)
+        {
+          controller.NotifyMark ();
+        }
+      observation_t ob = controller.GetObservation (10, 0, 20, estimator.GetRate (), nullptr);
+      NS_TEST_ASSERT_MSG_EQ (ob.size (), useEcn ? 6 : 4, "Wrong number of features");
+      if (useEcn)
+        {
+          NS_TEST_ASSERT_MSG_EQ (ob[4], 2, "Drops not observed");
+          NS_TEST_ASSERT_MSG_EQ (ob[5], 3, "Marks not observed");
+        }
+      NS_TEST_ASSERT_MSG_EQ_TOL (controller.CalculateReward (10, 0, 20, estimator), useEcn ? 0.25 : 0.5, 1e-6,
+                                 "Wrong signal penalty");
+    }
+
+  // A burst into 1 packet on the link and 20 queued: from 10 queued on the
+  // ECT arrivals are marked, from 20 on they are dropped
+  std::string fileName = CreateTempDirFilename ("ecn.bin");
+  FILE* f = std::fopen (fileName.c_str (), "wb");
+  NS_TEST_ASSERT_MSG_EQ (f != nullptr, true, "Cannot create the binary trace");
+  for (uint32_t i = 0; i < 46; i++)
+    {
+      TracePacket packet = {0, 1250, i};
+      BinaryPacketTrace::Write (f, packet);
+    }
+  std::fclose (f);
+  std::unique_ptr<PacketTrace> trace = OpenPacketTrace (fileName);
+  NS_TEST_ASSERT_MSG_EQ (trace != nullptr, true, "Cannot open the binary trace");
+  TraceQueueSimulator sim;
+  sim.SetServiceRate (1e6);
+  sim.SetBufferSize (20);
+  sim.GetController ().SetEcn (true, 0.5, 0.5);
+  sim.Run (*trace, 0.001);
+  NS_TEST_ASSERT_MSG_EQ (sim.GetMarks (), 10, "Wrong number of marks");
+  NS_TEST_ASSERT_MSG_EQ (sim.GetDrops (), 25, "Marked instead of dropped above the buffer size");
+}
+
+// Replays records in the given order and checks that the simulator clock
+// never goes back between them
+class OutOfOrderPacketTrace : public PacketTrace
+{
+public:
+  OutOfOrderPacketTrace (const TraceQueueSimulator& sim, const std::vector<TracePacket>& packets)
+    : m_sim (sim),
+      m_packets (packets),
+      m_next (0),
+      m_last (0),
+      m_backwards (false)
+  {
+  }
+
+  virtual bool Next (TracePacket& packet)
+  {
+    m_backwards = m_backwards || m_sim.GetTime () < m_last;
+    m_last = m_sim.GetTime ();
+    if (m_next == m_packets.size ())
+      {
+        return false;
+      }
+    packet = m_packets[m_next++];
+    return true;
+  }
+
+  bool WentBackwards (void) const
+  {
+    return m_backwards;
+  }
+
+private:
+  const TraceQueueSimulator& m_sim;
+  std::vector<TracePacket> m_packets;
+  uint32_t m_next;
+  double m_last;
+  bool m_backwards;
+};
+
+class TraceQueueSimulatorOrderTestCase : public TestCase
+{
+public:
+  TraceQueueSimulatorOrderTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TraceQueueSimulatorOrderTestCase::TraceQueueSimulatorOrderTestCase ()
+  : TestCase ("Check that out-of-order trace records do not move the clock back")
+{
+}
+
+void
+TraceQueueSimulatorOrderTestCase::DoRun (void)
+{
+  // The third record is older than the second, as in a reordered capture
+  std::vector<TracePacket> packets = {{0, 1250, 1}, {10000000, 1250, 2}, {5000000, 1250, 3}, {20000000, 1250, 4}};
+  TraceQueueSimulator sim;
+  sim.SetServiceRate (10e6);
+  OutOfOrderPacketTrace trace (sim, packets);
+  sim.Run (trace, 0);
+  NS_TEST_ASSERT_MSG_EQ (trace.WentBackwards (), false, "Clock moved back on an out-of-order record");
+  NS_TEST_ASSERT_MSG_EQ (sim.GetArrivals (), 4, "Out-of-order record not replayed");
+  NS_TEST_ASSERT_MSG_EQ (sim.GetDepartures (), 4, "Queue not drained");
+}
+
+class BufferControlCoreTestCase : public TestCase
+{
+public:
+  BufferControlCoreTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BufferControlCoreTestCase::BufferControlCoreTestCase ()
+  : TestCase ("Check that the specialized control core decides like BufferController")
+{
+}
+
+void
+BufferControlCoreTestCase::DoRun (void)
+{
+  BufferController controller;
+  controller.SetDesiredQueueDelay (0.001);
+  controller.SetEcn (true, 0.5, 0.5);
+  controller.Reset (20);
+  EwmaRateEstimator estimator (0.01);
+  estimator.Seed (1.25e6);
+
+  BufferControlCore<PacketSizing, EcnSchema> core (EwmaRateEstimator (0.01));
+  core.GetEstimator ().Seed (1.25e6);
+  core.SetDesiredQueueDelay (0.001);
+  core.SetEcn (0.5, 0.5);
+  core.Reset (20);
+
+  // Bursts of 3 arrivals per departure for 5 slots, then a draining queue
+  uint32_t size = 20;
+  uint32_t packets = 0;
+  uint64_t now = 0;
+  for (uint32_t slot = 0; slot < 10; slot++)
+    {
+      for (uint32_t i = 0; i < 40; i++)
+        {
+          now += 100000;
+          uint32_t arrivals = slot < 5 ? 3 : 0;
+          for (uint32_t a = 0; a < arrivals; a++)
+            {
+              bool admitted = core.Admit (packets, packets * 1000, 1000, 0, now);
+              NS_TEST_ASSERT_MSG_EQ (admitted, packets + 1 <= size, "Admission differs from the size limit");
+              if (!admitted)
+                {
+                  controller.NotifyArrival (false);
+                  continue;
+                }
+              NS_TEST_ASSERT_MSG_EQ (core.ShouldMark (packets, packets * 1000), controller.ShouldMark (packets),
+                                     "Marking differs");
+              if (controller.ShouldMark (packets))
+                {
+                  controller.NotifyMark ();
+                  core.NotifyMark ();
+                }
+              packets++;
+              controller.NotifyArrival (true);
+              core.NotifyEnqueue (true, 0, now);
+            }
+          if (packets > 0)
+            {
+              packets--;
+              estimator.Update (now * 1e-9, 1000, packets * 1000);
+              core.NotifyDequeue (1000, 0, now, packets * 1000);
+            }
+        }
+
+      observation_t ob = controller.GetObservation (packets, packets * 1000, size, estimator.GetRate (), nullptr);
+      BufferControlCore<PacketSizing, EcnSchema>::Observation coreOb;
+      core.Observe (packets, packets * 1000, coreOb);
+      NS_TEST_ASSERT_MSG_EQ (ob.size (), coreOb.size (), "Observation sizes differ");
+      for (uint32_t i = 0; i < ob.size (); i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ_TOL (coreOb[i], ob[i], 1e-9, "Observation feature " << i << " differs");
+        }
+      action_t action = controller.NativeAction (ob);
+      NS_TEST_ASSERT_MSG_EQ (NativeDecision ().Decide (core, coreOb), action, "Native actions differ");
+      size = controller.ApplyAction (action, size, packets);
+      NS_TEST_ASSERT_MSG_EQ (core.ApplyAction (action, packets, packets * 1000), size, "Buffer sizes differ");
+      float reward = controller.CalculateReward (packets, packets * 1000, size, estimator);
+      NS_TEST_ASSERT_MSG_EQ_TOL (core.CalculateReward (packets, packets * 1000), reward, 1e-6, "Rewards differ");
+    }
+  NS_TEST_ASSERT_MSG_EQ (core.GetDecisionCount (), controller.GetDecisionCount (), "Decision counts differ");
+  NS_TEST_ASSERT_MSG_LT (size, 20, "The heuristic never reduced the buffer");
+
+  // A byte-sized buffer admits by bytes and resizes by whole packets
+  BufferControlCore<ByteSizing, BaseSchema> bytes (EwmaRateEstimator (0.01));
+  bytes.Reset (3000);
+  NS_TEST_ASSERT_MSG_EQ (bytes.Admit (1, 1500, 1500, 0, 0), true, "Packet within the byte limit dropped");
+  NS_TEST_ASSERT_MSG_EQ (bytes.Admit (2, 2000, 1500, 0, 0), false, "Packet above the byte limit admitted");
+  NS_TEST_ASSERT_MSG_EQ (bytes.ApplyAction (0, 2, 2000), 4500, "Add did not grow the buffer by one packet");
+  NS_TEST_ASSERT_MSG_EQ (bytes.ApplyAction (2, 2, 4000), 4000, "Reduce went below the backlog");
+
+  // A tick without a decision still starts a new flow slot
+  BufferControlCore<PacketSizing, FlowSchema> flows (EwmaRateEstimator (0.01));
+  flows.SetFlowTable (16, 1000000000);
+  flows.Reset (20);
+  flows.NotifyEnqueue (true, 7, 0);
+  flows.NotifyDequeue (1000, 7, 0, 0);
+  NS_TEST_ASSERT_MSG_EQ (flows.GetFlowTable ().GetActiveFlows (), 1, "Dequeued flow not active");
+  flows.IdleSlot ();
+  NS_TEST_ASSERT_MSG_EQ (flows.GetFlowTable ().GetActiveFlows (), 0, "Idle slot not closed");
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -61,6 +798,16 @@ Ns3socketTestSuite::Ns3socketTestSuite ()
 {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new Ns3socketTestCase1, TestCase::QUICK);
+  AddTestCase (new DecisionStatsTestCase, TestCase::QUICK);
+  AddTestCase (new FlowTableTestCase, TestCase::QUICK);
+  AddTestCase (new RateEstimatorTestCase, TestCase::QUICK);
+  AddTestCase (new ClientDeadlineTestCase, TestCase::QUICK);
+  AddTestCase (new ClientLateSnapshotTestCase, TestCase::QUICK);
+  AddTestCase (new BufferControllerCongestionTestCase, TestCase::QUICK);
+  AddTestCase (new BufferControllerEcnTestCase, TestCase::QUICK);
+  AddTestCase (new TraceQueueSimulatorTestCase, TestCase::QUICK);
+  AddTestCase (new TraceQueueSimulatorOrderTestCase, TestCase::QUICK);
+  AddTestCase (new BufferControlCoreTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite